@@ -0,0 +1,322 @@
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "adjacency.h"
+
+// Compute the exclusive prefix sum of counts[0..n) into offsets[0..n].
+// offsets[n] is the total.  The counts are summed in blocks, one per
+// thread, then each block is scanned starting from the total of the
+// blocks before it.
+static void exclusiveScan(const LONG* counts, int n, vector<int>& offsets)
+{
+	const int MIN_BLOCK_SIZE = 64 * 1024;
+
+	offsets.resize(n + 1);
+
+	int nBlocks = 1;
+#ifdef _OPENMP
+	nBlocks = omp_get_max_threads();
+#endif
+	if (nBlocks > n / MIN_BLOCK_SIZE) nBlocks = n / MIN_BLOCK_SIZE;
+	if (nBlocks < 1) nBlocks = 1;
+
+	vector<int> blockStart(nBlocks + 1, 0);
+	int b;
+
+#pragma omp parallel for
+	for (b = 0; b < nBlocks; ++b)
+	{
+		const int first = (int) ((double) n * b / nBlocks);
+		const int last = (int) ((double) n * (b + 1) / nBlocks);
+		int sum = 0;
+		for (int i = first; i < last; ++i) sum += counts[i];
+		blockStart[b + 1] = sum;
+	}
+
+	for (b = 0; b < nBlocks; ++b)
+	{
+		blockStart[b + 1] += blockStart[b];
+	}
+
+#pragma omp parallel for
+	for (b = 0; b < nBlocks; ++b)
+	{
+		const int first = (int) ((double) n * b / nBlocks);
+		const int last = (int) ((double) n * (b + 1) / nBlocks);
+		int sum = blockStart[b];
+		for (int i = first; i < last; ++i)
+		{
+			offsets[i] = sum;
+			sum += counts[i];
+		}
+	}
+	offsets[n] = blockStart[nBlocks];
+}
+
+void CSRAdjacency::buildVertTris(const int* faces, int nTris, int nVerts)
+{
+	buildIncidence(faces, nTris, 3, nVerts);
+}
+
+void CSRAdjacency::buildVertEdges(const int* edgeVerts, int nEdges, int nVerts)
+{
+	buildIncidence(edgeVerts, nEdges, 2, nVerts);
+}
+
+// Build a vertex -> element adjacency w/ a counting sort:  count the
+// corners which use each vertex, turn the counts into row offsets, then
+// drop each element into the rows of its vertices.
+void CSRAdjacency::buildIncidence(const int* elemVerts, int nElems, int nCorners, int nVerts)
+{
+	vector<LONG> counts(nVerts, 0);
+	int i;
+
+#pragma omp parallel for
+	for (i = 0; i < nCorners * nElems; ++i)
+	{
+		InterlockedIncrement(&counts[elemVerts[i]]);
+	}
+
+	exclusiveScan(nVerts ? &counts[0] : 0, nVerts, _offsets);
+	_indices.resize(_offsets[nVerts]);
+
+	// counts[v] becomes the next free slot in row v
+#pragma omp parallel for
+	for (i = 0; i < nVerts; ++i)
+	{
+		counts[i] = _offsets[i];
+	}
+
+#pragma omp parallel for
+	for (i = 0; i < nCorners * nElems; ++i)
+	{
+		const int slot = InterlockedIncrement(&counts[elemVerts[i]]) - 1;
+		_indices[slot] = i / nCorners;
+	}
+
+	// The threads fill the rows in no particular order, so sort them.
+	// An element which uses a vertex twice is listed once.
+	sortAndPackRows();
+}
+
+// Same counting sort as buildIncidence(), but each pair only goes in
+// the row of its first index, & what's stored is its second index.
+void CSRAdjacency::buildFromPairs(const int* pairs, int nPairs, int nRows)
+{
+	vector<LONG> counts(nRows, 0);
+	int i;
+
+#pragma omp parallel for
+	for (i = 0; i < nPairs; ++i)
+	{
+		InterlockedIncrement(&counts[pairs[2 * i]]);
+	}
+
+	exclusiveScan(nRows ? &counts[0] : 0, nRows, _offsets);
+	_indices.resize(_offsets[nRows]);
+
+#pragma omp parallel for
+	for (i = 0; i < nRows; ++i)
+	{
+		counts[i] = _offsets[i];
+	}
+
+#pragma omp parallel for
+	for (i = 0; i < nPairs; ++i)
+	{
+		const int slot = InterlockedIncrement(&counts[pairs[2 * i]]) - 1;
+		_indices[slot] = pairs[2 * i + 1];
+	}
+
+	sortAndPackRows();
+}
+
+// Build the vertex -> vertex adjacency.  For each vertex, gather the
+// other corners of every triangle which uses it, then sort the rows &
+// remove the duplicates.
+void CSRAdjacency::buildVertNeighbors(const int* faces, const CSRAdjacency& vertTris)
+{
+	const int nVerts = vertTris.getNumRows();
+	vector<LONG> counts(nVerts, 0);
+	int v;
+
+	// Each time vertex v is a corner of a triangle, the other two
+	// corners are its neighbors.
+#pragma omp parallel for
+	for (v = 0; v < nVerts; ++v)
+	{
+		LONG count = 0;
+		for (const int* pt = vertTris.rowBegin(v); pt != vertTris.rowEnd(v); ++pt)
+		{
+			const int* f = faces + 3 * *pt;
+			count += 2 * ((f[0] == v) + (f[1] == v) + (f[2] == v));
+		}
+		counts[v] = count;
+	}
+
+	exclusiveScan(nVerts ? &counts[0] : 0, nVerts, _offsets);
+	_indices.resize(_offsets[nVerts]);
+
+#pragma omp parallel for
+	for (v = 0; v < nVerts; ++v)
+	{
+		int slot = _offsets[v];
+		for (const int* pt = vertTris.rowBegin(v); pt != vertTris.rowEnd(v); ++pt)
+		{
+			const int* f = faces + 3 * *pt;
+			for (int c = 0; c < 3; ++c)
+			{
+				if (f[c] != v) continue;
+				_indices[slot++] = f[(c + 1) % 3];
+				_indices[slot++] = f[(c + 2) % 3];
+			}
+		}
+	}
+
+	sortAndPackRows();
+}
+
+// Sort each row & remove duplicates.  If any row got shorter, move the
+// rows down so they're back to back again.
+void CSRAdjacency::sortAndPackRows()
+{
+	const int nRows = getNumRows();
+	vector<LONG> sizes(nRows);
+	int i;
+
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (i = 0; i < nRows; ++i)
+	{
+		int* first = _indices.empty() ? 0 : &_indices[0] + _offsets[i];
+		int* last = _indices.empty() ? 0 : &_indices[0] + _offsets[i + 1];
+		sort(first, last);
+		sizes[i] = (LONG) (unique(first, last) - first);
+	}
+
+	vector<int> packedOffsets;
+	exclusiveScan(nRows ? &sizes[0] : 0, nRows, packedOffsets);
+	if (packedOffsets[nRows] == getNumEntries())
+	{
+		return; // no duplicates were removed
+	}
+
+	vector<int> packedIndices(packedOffsets[nRows]);
+
+#pragma omp parallel for
+	for (i = 0; i < nRows; ++i)
+	{
+		for (int j = 0; j < sizes[i]; ++j)
+		{
+			packedIndices[packedOffsets[i] + j] = _indices[_offsets[i] + j];
+		}
+	}
+
+	_offsets.swap(packedOffsets);
+	_indices.swap(packedIndices);
+}
+
+
+// Copy a CSR adjacency, leaving spare slots after each row
+void MutableAdjacency::assign(const CSRAdjacency& adj, int slack)
+{
+	const int nRows = adj.getNumRows();
+
+	_start.resize(nRows);
+	_size.resize(nRows);
+	_capacity.resize(nRows);
+	_indices.resize(adj.getNumEntries() + (size_t) nRows * slack);
+
+	int i;
+
+#pragma omp parallel for
+	for (i = 0; i < nRows; ++i)
+	{
+		_start[i] = adj.rowStart(i) + i * slack;
+		_size[i] = adj.rowSize(i);
+		_capacity[i] = _size[i] + slack;
+		copy(adj.rowBegin(i), adj.rowEnd(i), _indices.begin() + _start[i]);
+	}
+}
+
+void MutableAdjacency::clear()
+{
+	_start.clear();
+	_size.clear();
+	_capacity.clear();
+	_indices.clear();
+}
+
+// Add value to row i, keeping the row sorted
+void MutableAdjacency::insert(int i, int value)
+{
+	vector<int>::iterator first = _indices.begin() + _start[i];
+	vector<int>::iterator last = first + _size[i];
+	vector<int>::iterator pos = lower_bound(first, last, value);
+	if (pos != last && *pos == value)
+	{
+		return; // already in the row
+	}
+
+	if (_size[i] == _capacity[i])
+	{
+		const int slot = (int) (pos - first);
+		growRow(i, 2 * _capacity[i] + 1);
+		first = _indices.begin() + _start[i];
+		last = first + _size[i];
+		pos = first + slot;
+	}
+
+	copy_backward(pos, last, last + 1);
+	*pos = value;
+	++_size[i];
+}
+
+// Remove value from row i, keeping the row sorted
+unsigned MutableAdjacency::erase(int i, int value)
+{
+	vector<int>::iterator first = _indices.begin() + _start[i];
+	vector<int>::iterator last = first + _size[i];
+	vector<int>::iterator pos = lower_bound(first, last, value);
+	if (pos == last || *pos != value)
+	{
+		return 0; // not in the row
+	}
+
+	copy(pos + 1, last, pos);
+	--_size[i];
+	return 1;
+}
+
+// Move row i to the end of the array.  The slots it used are left
+// empty; a row only moves when it outgrows its slots, so the wasted
+// space is bounded by the capacity of the rows which grew.
+void MutableAdjacency::reserve(int i, int capacity)
+{
+	if (_capacity[i] < capacity)
+	{
+		growRow(i, max(capacity, 2 * _capacity[i] + 1));
+	}
+}
+
+void MutableAdjacency::growRow(int i, int minCapacity)
+{
+	const int newStart = (int) _indices.size();
+	_indices.resize(newStart + minCapacity);
+	copy(_indices.begin() + _start[i], _indices.begin() + _start[i] + _size[i],
+		_indices.begin() + newStart);
+	_start[i] = newStart;
+	_capacity[i] = minCapacity;
+}
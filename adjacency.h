@@ -0,0 +1,134 @@
+#ifndef __adjacency_h
+#define __adjacency_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// One row of an adjacency:  a sorted range of indices.  This is a
+// view into the adjacency, so it's only good until the row changes.
+class AdjacencyRow
+{
+public:
+	AdjacencyRow(const int* first, const int* last) : _first(first), _last(last) {};
+
+	const int* begin() const {return _first;}
+	const int* end() const {return _last;}
+
+	int size() const {return (int) (_last - _first);}
+	bool empty() const {return _first == _last;}
+
+	bool contains(int i) const {return binary_search(_first, _last, i);}
+
+private:
+	const int* _first;
+	const int* _last;
+};
+
+// Compressed sparse row (CSR) adjacency.  Row i is stored in
+// _indices[_offsets[i]] ... _indices[_offsets[i + 1] - 1], sorted
+// in increasing order, with no duplicates.  All the rows share one
+// array, so there is no per-neighbor allocation.
+class CSRAdjacency
+{
+public:
+	CSRAdjacency() {};
+
+	int getNumRows() const {return _offsets.empty() ? 0 : (int) _offsets.size() - 1;}
+	int getNumEntries() const {return (int) _indices.size();}
+
+	int rowStart(int i) const {return _offsets[i];}
+	int rowSize(int i) const {return _offsets[i + 1] - _offsets[i];}
+	const int* rowBegin(int i) const {return _indices.empty() ? 0 : &_indices[0] + _offsets[i];}
+	const int* rowEnd(int i) const {return _indices.empty() ? 0 : &_indices[0] + _offsets[i + 1];}
+	AdjacencyRow row(int i) const {return AdjacencyRow(rowBegin(i), rowEnd(i));}
+
+	// Build the vertex -> triangle adjacency from an array of vertex
+	// indices, three per triangle.  Row v lists the triangles which use
+	// vertex v.
+	void buildVertTris(const int* faces, int nTris, int nVerts);
+
+	// Build the vertex -> edge adjacency from an array of vertex indices,
+	// two per edge.  Row v lists the edges which use vertex v.
+	void buildVertEdges(const int* edgeVerts, int nEdges, int nVerts);
+
+	// Build the vertex -> vertex adjacency from the same array of vertex
+	// indices & the vertex -> triangle adjacency.  Row v lists the vertices
+	// which share an edge w/ vertex v.  (If a triangle uses a vertex twice,
+	// the vertex is its own neighbor, same as when the neighbors were
+	// inserted one triangle at a time.)
+	void buildVertNeighbors(const int* faces, const CSRAdjacency& vertTris);
+
+	// Build a directed graph from an array of pairs (from, to).  Row i
+	// lists the "to" of every pair whose "from" is i.
+	void buildFromPairs(const int* pairs, int nPairs, int nRows);
+
+private:
+	vector<int> _offsets; // start of each row, plus one past the end of the last
+	vector<int> _indices; // all the rows, back to back
+
+	// Build the vertex -> element adjacency, where element e uses the
+	// nCorners vertices elemVerts[nCorners * e] ...
+	void buildIncidence(const int* elemVerts, int nElems, int nCorners, int nVerts);
+
+	// Sort each row & remove duplicates, then pack the rows together.
+	void sortAndPackRows();
+};
+
+// CSR adjacency which can be changed a row at a time.  Each row keeps
+// some spare slots at its end, so adding a neighbor usually just shifts
+// the larger entries of that row up by one.  A row which runs out of
+// room is moved to the end of the array w/ twice the capacity.  The rows
+// stay sorted, w/ no duplicates, so they can be walked in the same order
+// as a set<int>.
+class MutableAdjacency
+{
+public:
+	MutableAdjacency() {};
+
+	// Copy a CSR adjacency, leaving "slack" spare slots after each row
+	void assign(const CSRAdjacency& adj, int slack);
+
+	void clear();
+
+	int getNumRows() const {return (int) _start.size();}
+
+	AdjacencyRow row(int i) const
+	{
+		const int* first = _indices.empty() ? 0 : &_indices[0] + _start[i];
+		return AdjacencyRow(first, first + _size[i]);
+	}
+
+	bool contains(int i, int value) const {return row(i).contains(value);}
+
+	// Add value to row i (if it's not already there)
+	void insert(int i, int value);
+
+	// Remove value from row i.  Returns the # of entries removed (0 or 1),
+	// like set<int>::erase.
+	unsigned erase(int i, int value);
+
+	// Make room in row i for capacity entries.  Up to that many, inserts
+	// don't move the row, so different rows can be changed by different
+	// threads.  (Moving a row may move all of them.)
+	void reserve(int i, int capacity);
+
+private:
+	vector<int> _start; // first slot of each row
+	vector<int> _size; // # of entries in each row
+	vector<int> _capacity; // # of slots reserved for each row
+	vector<int> _indices; // all the rows, w/ spare slots
+
+	// Move row i to the end of _indices, w/ room for at least minCapacity entries
+	void growRow(int i, int minCapacity);
+};
+
+#endif // __adjacency_h
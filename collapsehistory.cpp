@@ -0,0 +1,89 @@
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <algorithm>
+#include "collapsehistory.h"
+
+void CollapseHistory::clear()
+{
+	_records.clear();
+	_tris.clear();
+	_positions.clear();
+}
+
+void CollapseHistory::append(const EdgeCollapse& ec)
+{
+	CollapseRecord r;
+	r._vfrom = ec._vfrom;
+	r._vto = ec._vto;
+	r._firstTri = (int) _tris.size();
+	r._nTrisRemoved = (int) ec._trisRemoved.size();
+	r._nTrisAffected = (int) ec._trisAffected.size();
+	r._nTrisMoved = (int) ec._trisMoved.size();
+	r._move = -1;
+
+	_tris.insert(_tris.end(), ec._trisRemoved.begin(), ec._trisRemoved.end());
+	_tris.insert(_tris.end(), ec._trisAffected.begin(), ec._trisAffected.end());
+	_tris.insert(_tris.end(), ec._trisMoved.begin(), ec._trisMoved.end());
+
+	// Most "to vertices" stay where they are, so only the ones which move
+	// keep their positions
+	if (ec._position != ec._oldPosition)
+	{
+		r._move = (int) _positions.size();
+		_positions.push_back(ec._oldPosition);
+		_positions.push_back(ec._position);
+	}
+
+	_records.push_back(r);
+}
+
+void CollapseHistory::trim()
+{
+	vector<CollapseRecord>(_records).swap(_records);
+	vector<int>(_tris).swap(_tris);
+	vector<Vec3>(_positions).swap(_positions);
+}
+
+void CollapseHistory::renumber(const vector<int>& newVert, const vector<int>& newTri)
+{
+	int i;
+	for (i = 0; i < (int) _tris.size(); ++i)
+	{
+		_tris[i] = newTri[_tris[i]];
+	}
+
+	for (i = 0; i < (int) _records.size(); ++i)
+	{
+		CollapseRecord& r = _records[i];
+		r._vfrom = newVert[r._vfrom];
+		r._vto = newVert[r._vto];
+
+		vector<int>::iterator first = _tris.begin() + r._firstTri;
+		sort(first, first + r._nTrisRemoved);
+		first += r._nTrisRemoved;
+		sort(first, first + r._nTrisAffected);
+		first += r._nTrisAffected;
+		sort(first, first + r._nTrisMoved);
+	}
+}
+
+size_t CollapseCheckpoint::bytesUsed() const
+{
+	return sizeof(CollapseCheckpoint) +
+		   _activeTris.size() * sizeof(unsigned) +
+		   _changedTris.size() * sizeof(int) +
+		   _changedCorners.size() * sizeof(int) +
+		   _movedVerts.size() * sizeof(int) +
+		   _movedPositions.size() * sizeof(Vec3);
+}
+
+size_t CollapseHistory::bytesUsed() const
+{
+	return _records.size() * sizeof(CollapseRecord) +
+		   _tris.size() * sizeof(int) +
+		   _positions.size() * sizeof(Vec3);
+}
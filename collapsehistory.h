@@ -0,0 +1,167 @@
+#ifndef __collapsehistory_h
+#define __collapsehistory_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <vector>
+#include <iostream>
+#include "vec3.h"
+#include "adjacency.h"
+
+using namespace std;
+
+// The edge collapse structure.  The "from vertex" will
+// be collapsed to the "to vertex."  This may flatten some
+// triangles, which will be removed, and will affect those
+// triangles which contain the "from vertex".  Those triangles
+// will be updated with the new vertex.  If the "to vertex" is
+// moved (see PMesh::Placement), the triangles which already use it
+// change shape too.
+//
+// This is the form used while the list of edge collapses is built.
+// The triangles are sorted, w/o repeats, & the vectors keep their
+// memory when the structure is reused.  The list itself is kept in a
+// CollapseHistory.
+struct EdgeCollapse
+{
+	int _vfrom;
+	int _vto;
+	vector<int> _trisRemoved;
+	vector<int> _trisAffected;
+	vector<int> _trisMoved; // other triangles of the "to vertex", if it's moved
+	Vec3 _position; // where the "to vertex" is after the collapse
+	Vec3 _oldPosition; // where it was before, so splitting the vertex can put it back
+
+	// Empty the triangles, so the structure can be used for the next collapse
+	void clear()
+	{
+		_trisRemoved.clear();
+		_trisAffected.clear();
+		_trisMoved.clear();
+	}
+
+	// Used for debugging
+	void dumpEdgeCollapse()
+	{
+		std::cout << "**** Edge Collapse Dump ****" << std::endl;
+
+		std::cout << "\tFrom Vert# " << _vfrom << " to Vert# " << _vto << std::endl;
+		std::cout << "\tTo Vert moved from " << _oldPosition << " to " << _position << std::endl;
+		cout << "\tTris removed:";
+		vector<int>::iterator pos;
+		for (pos = _trisRemoved.begin(); pos != _trisRemoved.end(); ++pos)
+		{
+			std::cout << " " << *pos;
+		}
+		cout << std::endl << "\tTris affected:";
+		for (pos = _trisAffected.begin(); pos != _trisAffected.end(); ++pos)
+		{
+			std::cout << " " << *pos;
+		}
+		cout << std::endl << "\tTris moved:";
+		for (pos = _trisMoved.begin(); pos != _trisMoved.end(); ++pos)
+		{
+			std::cout << " " << *pos;
+		}
+		std::cout  << std::endl << "**** End of Edge Collapse Dump ****" << std::endl;
+	}
+};
+
+// One edge collapse in a CollapseHistory.  Its triangles are stored in
+// the history's pool of triangle indices:  the removed ones, then the
+// affected ones, then the moved ones.
+struct CollapseRecord
+{
+	int _vfrom;
+	int _vto;
+	int _firstTri; // where its triangles start in the pool
+	int _nTrisRemoved;
+	int _nTrisAffected;
+	int _nTrisMoved;
+	int _move; // where its positions start, if the "to vertex" moves, else -1
+};
+
+// The list of edge collapses, in the order they're done.  Every collapse
+// is a fixed size record, & all their triangles share one pool, so a
+// collapse takes a few dozen bytes, w/ no allocation of its own, & any
+// collapse can be found by its number.
+class CollapseHistory
+{
+public:
+	CollapseHistory() {};
+
+	void clear();
+
+	// Add an edge collapse to the end of the history
+	void append(const EdgeCollapse& ec);
+
+	// number of edge collapses
+	int size() const {return (int) _records.size();}
+	bool empty() const {return _records.empty();}
+
+	const CollapseRecord& operator[](int i) const {return _records[i];}
+
+	// The triangles of edge collapse i, sorted
+	AdjacencyRow trisRemoved(int i) const {return tris(_records[i]._firstTri, _records[i]._nTrisRemoved);}
+	AdjacencyRow trisAffected(int i) const
+	{
+		const CollapseRecord& r = _records[i];
+		return tris(r._firstTri + r._nTrisRemoved, r._nTrisAffected);
+	}
+	AdjacencyRow trisMoved(int i) const
+	{
+		const CollapseRecord& r = _records[i];
+		return tris(r._firstTri + r._nTrisRemoved + r._nTrisAffected, r._nTrisMoved);
+	}
+
+	// Where the "to vertex" of edge collapse i is before & after it
+	bool movesToVert(int i) const {return _records[i]._move >= 0;}
+	const Vec3& oldPosition(int i) const {return _positions[_records[i]._move];}
+	const Vec3& position(int i) const {return _positions[_records[i]._move + 1];}
+
+	// Free the spare memory of the arrays, once the history is built
+	void trim();
+
+	// Renumber the vertices & triangles of the collapses (see
+	// Mesh::renumber).  The triangles of each collapse are sorted again.
+	void renumber(const vector<int>& newVert, const vector<int>& newTri);
+
+	// Bytes used by the history (not counting spare capacity)
+	size_t bytesUsed() const;
+
+private:
+	vector<CollapseRecord> _records;
+	vector<int> _tris; // the triangles of every collapse, back to back
+	vector<Vec3> _positions; // old & new position of each "to vertex" which moves
+
+	AdjacencyRow tris(int first, int n) const
+	{
+		const int* p = _tris.empty() ? 0 : &_tris[0] + first;
+		return AdjacencyRow(p, p + n);
+	}
+};
+
+// The state of the mesh after some number of edge collapses, so it can
+// be restored w/o replaying the collapses before it (see
+// PMesh::setCheckpointInterval).  Besides which triangles are active,
+// only what's different from the original mesh is kept.
+struct CollapseCheckpoint
+{
+	int _nCollapses; // # of edge collapses done
+
+	vector<unsigned> _activeTris; // 1 bit per triangle
+	vector<int> _changedTris; // 4 per triangle w/ other vertices:  its index & vertices
+	vector<int> _changedCorners; // 2 per corner w/ another opposite:  the corner & opposite
+	vector<int> _movedVerts; // vertices which aren't where they were...
+	vector<Vec3> _movedPositions; // ...& where they are
+
+	// Bytes used by the checkpoint (not counting spare capacity)
+	size_t bytesUsed() const;
+};
+
+#endif // __collapsehistory_h
@@ -0,0 +1,174 @@
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <algorithm>
+
+#include "cornertable.h"
+#include "mesh.h"
+
+// Link the corners of all the triangles.  Each edge is linked from its
+// lower-numbered vertex, so each corner is written by one thread.
+void CornerTable::build(const Mesh& m)
+{
+	const int nVerts = m.getNumVerts();
+	int v;
+
+	_opposite.assign(3 * (size_t) m.getNumTriangles(), (int) BORDER);
+
+#pragma omp parallel
+	{
+		vector<RingEdge> ring;
+
+#pragma omp for schedule(dynamic, 1024)
+		for (v = 0; v < nVerts; ++v)
+		{
+			relinkVert(m, v, true, ring);
+		}
+	}
+}
+
+// The table says whether the edge is on the border directly, unless the
+// edge is non-manifold.  Then count the triangles the two vertices have
+// in common.
+bool CornerTable::isBorderEdge(const Mesh& m, int c, int v, int n) const
+{
+	const int o = _opposite[c];
+	if (NONMANIFOLD != o)
+	{
+		return (BORDER == o);
+	}
+
+	int triCount = 0;
+	const AdjacencyRow triNeighbors = m.getTriNeighbors(n);
+	for (const int* pos = triNeighbors.begin(); pos != triNeighbors.end(); ++pos)
+	{
+		if (m.getTri(*pos).hasVertex(v))
+		{
+			++triCount;
+		}
+	}
+	return (1 == triCount);
+}
+
+// Gather the edges around vertex v, from the corners of each active
+// triangle which uses it.
+void CornerTable::getRing(const Mesh& m, int v, vector<RingEdge>& ring)
+{
+	ring.clear();
+
+	const AdjacencyRow tris = m.getTriNeighbors(v);
+	for (const int* pt = tris.begin(); pt != tris.end(); ++pt)
+	{
+		const triangle& t = m.getTri(*pt);
+		if (!t.isActive()) continue;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (t.getVertIndex(k) != v) continue;
+
+			const int c = 3 * *pt + k;
+			RingEdge e;
+
+			// edge to the next vertex faces the previous corner, & vice versa
+			e.vert = t.getVertIndex((k + 1) % 3);
+			e.corner = prev(c);
+			if (e.vert != v) ring.push_back(e);
+
+			e.vert = t.getVertIndex((k + 2) % 3);
+			e.corner = next(c);
+			if (e.vert != v) ring.push_back(e);
+		}
+	}
+
+	sort(ring.begin(), ring.end());
+}
+
+// Link the corners which face each edge around vertex v.  An edge w/
+// one corner is a border edge, an edge w/ two corners (from different
+// triangles) links them, & any other edge is non-manifold.
+void CornerTable::relinkVert(const Mesh& m, int v, bool bHigherOnly, vector<RingEdge>& ring)
+{
+	getRing(m, v, ring);
+
+	size_t i, j;
+	for (i = 0; i < ring.size(); i = j)
+	{
+		for (j = i + 1; j < ring.size() && ring[j].vert == ring[i].vert; ++j) {}
+
+		if (bHigherOnly && ring[i].vert < v)
+		{
+			continue; // linked from the other end of the edge
+		}
+
+		if (j - i == 1)
+		{
+			_opposite[ring[i].corner] = BORDER;
+		}
+		else if (j - i == 2 && triOf(ring[i].corner) != triOf(ring[i + 1].corner))
+		{
+			_opposite[ring[i].corner] = ring[i + 1].corner;
+			_opposite[ring[i + 1].corner] = ring[i].corner;
+		}
+		else
+		{
+			for (size_t k = i; k < j; ++k)
+			{
+				_opposite[ring[k].corner] = NONMANIFOLD;
+			}
+		}
+	}
+}
+
+// Triangle t (vFrom, vTo, x) collapses to the edge (vTo, x).  The
+// triangles across its edges (vFrom, x) & (vTo, x) now share that edge.
+// If the triangle doesn't use both vertices, it's just cut out of the
+// mesh.  The corners of t itself are left alone, so restoreTri() can
+// link them back in.
+void CornerTable::removeTri(const Mesh& m, int t, int vFrom, int vTo)
+{
+	const triangle& tri = m.getTri(t);
+	int cFrom = -1, cTo = -1;
+	int k;
+
+	for (k = 0; k < 3; ++k)
+	{
+		if (tri.getVertIndex(k) == vFrom) cFrom = 3 * t + k;
+		else if (tri.getVertIndex(k) == vTo) cTo = 3 * t + k;
+	}
+
+	for (k = 0; k < 3; ++k)
+	{
+		const int c = 3 * t + k;
+		const int o = _opposite[c];
+		if (o < 0 || _opposite[o] != c) continue;
+
+		if (c == cFrom && cTo >= 0)
+		{
+			_opposite[o] = _opposite[cTo];
+		}
+		else if (c == cTo && cFrom >= 0)
+		{
+			_opposite[o] = _opposite[cFrom];
+		}
+		else
+		{
+			_opposite[o] = BORDER;
+		}
+	}
+}
+
+// Link the corners of triangle t back in
+void CornerTable::restoreTri(int t)
+{
+	for (int c = 3 * t; c < 3 * t + 3; ++c)
+	{
+		if (_opposite[c] >= 0)
+		{
+			_opposite[_opposite[c]] = c;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef __cornertable_h
+#define __cornertable_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <vector>
+
+using namespace std;
+
+class Mesh;
+
+// Corner table for the triangles of a mesh.  Corner c is corner c % 3
+// of triangle c / 3 (i.e. the triangle's 1st, 2nd or 3rd vertex).  The
+// opposite of a corner is the corner which faces the same edge from the
+// other triangle which uses that edge.  This gives the triangles on an
+// edge, and tells whether an edge is on the border, w/o searching.
+//
+// An edge used by only one active triangle is a border edge.  An edge
+// used by more than two triangles (or by a triangle which uses a vertex
+// twice) is non-manifold, and has to be handled by searching the
+// triangle neighbors of its vertices.
+class CornerTable
+{
+public:
+	enum {BORDER = -1, NONMANIFOLD = -2}; // opposites which aren't corners
+
+	CornerTable() {};
+
+	static int triOf(int c) {return c / 3;}
+	static int next(int c) {return (2 == c % 3) ? c - 2 : c + 1;}
+	static int prev(int c) {return (0 == c % 3) ? c + 2 : c - 1;}
+
+	// Corner facing the same edge as corner c, or BORDER, or NONMANIFOLD
+	int opposite(int c) const {return _opposite[c];}
+	void setOpposite(int c, int o) {_opposite[c] = o;}
+
+	// Is the edge facing corner c, from vertex v to vertex n, used by only
+	// one triangle?  This is a lookup, unless the edge is non-manifold.
+	bool isBorderEdge(const Mesh& m, int c, int v, int n) const;
+
+	// Find the opposite of every corner, from the triangles & the
+	// triangle neighbors of each vertex.
+	void build(const Mesh& m);
+
+	void clear() {_opposite.clear();}
+
+	// Find the opposites of the corners on the edges around vertex v
+	// again, after the triangles around it have changed.  Used while
+	// the edge collapse list is built, when the triangle neighbors of
+	// each vertex are kept up to date.
+	void relinkVert(const Mesh& m, int v) {relinkVert(m, v, false, _ring);}
+
+	// Update the table when triangle t is removed by collapsing vertex
+	// vFrom to vertex vTo:  the triangles on either side of it become
+	// neighbors.  restoreTri() undoes this, as long as the collapses
+	// are undone in the reverse order.
+	void removeTri(const Mesh& m, int t, int vFrom, int vTo);
+	void restoreTri(int t);
+
+	// One edge of the ring around a vertex:  the vertex at the other end
+	// of the edge & the corner which faces the edge.
+	struct RingEdge
+	{
+		int vert;
+		int corner;
+
+		bool operator<(const RingEdge& e) const
+		{
+			return (vert < e.vert || (vert == e.vert && corner < e.corner));
+		}
+	};
+
+	// Get the edges around vertex v, two for each active triangle which
+	// uses it, sorted by the vertex at the other end.  The corners which
+	// face the same edge end up next to each other, in triangle order.
+	static void getRing(const Mesh& m, int v, vector<RingEdge>& ring);
+
+	// Same as relinkVert() above, w/ the caller's scratch space, so
+	// different vertices can be relinked by different threads (as long
+	// as they don't share any triangles).
+	void relinkVert(const Mesh& m, int v, vector<RingEdge>& ring) {relinkVert(m, v, false, ring);}
+
+private:
+	vector<int> _opposite; // opposite of each corner
+	vector<RingEdge> _ring; // scratch space for relinkVert()
+
+	// If bHigherOnly is true, only the edges to higher-numbered vertices
+	// are linked, so the vertices can be handled in parallel.  ring is
+	// scratch space.
+	void relinkVert(const Mesh& m, int v, bool bHigherOnly, vector<RingEdge>& ring);
+};
+
+#endif // __cornertable_h
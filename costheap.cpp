@@ -0,0 +1,119 @@
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <assert.h>
+
+#include "costheap.h"
+
+void CostHeap::reset(int n)
+{
+	_entries.clear();
+	_entries.reserve(n);
+	_positions.assign(n, NOT_IN_HEAP);
+	_nextSeq = 0;
+}
+
+void CostHeap::push(int i, double cost)
+{
+	assert(!contains(i));
+
+	Entry e;
+	e.cost = cost;
+	e.seq = _nextSeq++;
+	e.index = i;
+
+	_entries.push_back(e);
+	_positions[i] = size() - 1;
+	siftUp(size() - 1);
+}
+
+void CostHeap::pop()
+{
+	assert(!empty());
+	erase(top());
+}
+
+void CostHeap::erase(int i)
+{
+	const int pos = _positions[i];
+	if (NOT_IN_HEAP == pos) return;
+
+	_positions[i] = NOT_IN_HEAP;
+
+	// Move the last entry into the hole, then move it up or down
+	const Entry last = _entries.back();
+	_entries.pop_back();
+	if (pos == size()) return; // i was the last entry
+
+	const bool bUp = last < _entries[pos];
+	place(last, pos);
+	if (bUp) {
+		siftUp(pos);
+	} else {
+		siftDown(pos);
+	}
+}
+
+void CostHeap::update(int i, double cost)
+{
+	const int pos = _positions[i];
+	if (NOT_IN_HEAP == pos) {
+		push(i, cost);
+		return;
+	}
+
+	// A new cost goes behind equal costs, as if i was inserted again
+	Entry e;
+	e.cost = cost;
+	e.seq = _nextSeq++;
+	e.index = i;
+
+	const bool bUp = e < _entries[pos];
+	_entries[pos] = e;
+	if (bUp) {
+		siftUp(pos);
+	} else {
+		siftDown(pos);
+	}
+}
+
+// Move the entry at pos up until its parent is lower
+void CostHeap::siftUp(int pos)
+{
+	const Entry e = _entries[pos];
+	while (pos > 0)
+	{
+		const int parent = (pos - 1) / ARITY;
+		if (!(e < _entries[parent])) break;
+		place(_entries[parent], pos);
+		pos = parent;
+	}
+	place(e, pos);
+}
+
+// Move the entry at pos down until it's lower than all its children
+void CostHeap::siftDown(int pos)
+{
+	const Entry e = _entries[pos];
+	const int n = size();
+	for (;;)
+	{
+		const int first = ARITY * pos + 1;
+		if (first >= n) break;
+
+		const int last = (first + ARITY < n) ? first + ARITY : n;
+		int best = first;
+		for (int c = first + 1; c < last; ++c)
+		{
+			if (_entries[c] < _entries[best]) best = c;
+		}
+		if (!(_entries[best] < e)) break;
+
+		place(_entries[best], pos);
+		pos = best;
+	}
+	place(e, pos);
+}
@@ -0,0 +1,75 @@
+#ifndef __costheap_h
+#define __costheap_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <vector>
+
+using namespace std;
+
+// Priority queue of indices (vertices or edges), ordered by edge
+// collapse cost (lowest first).  This is an indexed 4-ary heap:  the
+// cost is stored in the heap entry, and _positions[i] is where index i
+// is in the heap (or NOT_IN_HEAP), so a cost can be changed in place.
+//
+// Indices with equal costs come out in the order their costs were
+// last set, so the order is the same as inserting into a multiset.
+class CostHeap
+{
+public:
+	enum {NOT_IN_HEAP = -1};
+
+	CostHeap() : _nextSeq(0) {};
+
+	// Empty the heap & make room for indices 0 ... n - 1
+	void reset(int n);
+
+	int size() const {return (int) _entries.size();}
+	bool empty() const {return _entries.empty();}
+
+	bool contains(int i) const {return NOT_IN_HEAP != _positions[i];}
+
+	// Index with the lowest cost, & its cost
+	int top() const {return _entries[0].index;}
+	double topCost() const {return _entries[0].cost;}
+
+	// cost of an index in the heap
+	double getCost(int i) const {return _entries[_positions[i]].cost;}
+
+	void push(int i, double cost); // i must not be in the heap
+	void pop(); // remove the top index
+	void erase(int i); // remove i, if it's in the heap
+
+	// Change the cost of i, or add i if it's not in the heap
+	void update(int i, double cost);
+
+private:
+	enum {ARITY = 4};
+
+	struct Entry
+	{
+		double cost;
+		unsigned int seq; // breaks ties between equal costs
+		int index;
+
+		bool operator<(const Entry& e) const
+		{
+			return cost < e.cost || (cost == e.cost && seq < e.seq);
+		}
+	};
+
+	void siftUp(int pos);
+	void siftDown(int pos);
+	void place(const Entry& e, int pos) {_entries[pos] = e; _positions[e.index] = pos;}
+
+	vector<Entry> _entries;
+	vector<int> _positions; // position of each index in _entries
+	unsigned int _nextSeq;
+};
+
+#endif // __costheap_h
@@ -59,7 +59,9 @@ int glModelWindow::initOpenGL(GLvoid)
 
 	glEnable(GL_DEPTH_TEST);
 
-	glEnable(GL_CULL_FACE); // backface culling
+	// Both sides of the triangles are lit (the back w/ the normals
+	// flipped), so each triangle only has to be drawn once, w/o culling
+	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
 	
 	return true;
 }
@@ -75,6 +77,23 @@ bool glModelWindow::displayMesh()
 
     glRotatef(elevation_,1,0,0);
     glRotatef(azimuth_,0,1,0);
+
+	// Refine the mesh for the view, a few milliseconds per frame, & keep
+	// repainting while it's changing
+	if (g_pProgMesh && bViewDependent_)
+	{
+		GLfloat modelview[16], projection[16];
+		glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+		glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+		ViewParams view;
+		view.setFromMatrices(modelview, projection, height_, VIEW_MAX_ERROR);
+		if (g_pProgMesh->refineForView(view, VIEW_REFINE_SECONDS) > 0)
+		{
+			displayWindowTitle();
+			InvalidateRect(hWnd_, NULL, FALSE);
+		}
+	}
 	
 	if (bSmooth_)
 	{
@@ -87,84 +106,31 @@ bool glModelWindow::displayMesh()
 
 	if (bFill_) // fill in triangles or just display outlines?
 	{
-		glPolygonMode( GL_FRONT, GL_FILL );
+		glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
 	}
 	else
 	{
-		glPolygonMode( GL_FRONT, GL_LINE );
+		glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
 	}
 
-	// NOTE: we could use display lists here.  That would speed things
-	// up which the user is rotating the mesh.  However, since speed isn't
-	// a bit issue, I didn't use them.
+	// The level of detail is drawn from vertex arrays, which PMesh only
+	// rebuilds when the level of detail changes.  Both sides of each
+	// triangle are drawn (see initOpenGL).
 	if (g_pProgMesh)
 	{
 		// Make everything grey
 		glColor3ub(128, 128, 128);
-		glBegin(GL_TRIANGLES);
-		for (int i=0; i<g_pProgMesh->numTris(); i++)
+		if (bSmooth_)
 		{
-			triangle t;
-			float a[3];
-			if (g_pProgMesh->getTri(i, t) && t.isActive())
-			{
-				if (bSmooth_)
-				{
-					const vertex& v1 = t.getVert1vertex();
-					const float* pFltV1Norm = v1.getArrayVertNorms();
-					glNormal3fv(pFltV1Norm);
-					const float* pFltArray1 = v1.getArrayVerts();
-					glVertex3fv(pFltArray1);
-					const vertex& v2 = t.getVert2vertex();
-					const float* pFltV2Norm = v2.getArrayVertNorms();
-					glNormal3fv(pFltV2Norm);
-					const float* pFltArray2 = v2.getArrayVerts();
-					glVertex3fv(pFltArray2);
-					const vertex& v3 = t.getVert3vertex();
-					const float* pFltV3Norm = v3.getArrayVertNorms();
-					glNormal3fv(pFltV3Norm);
-					const float* pFltArray3 = v3.getArrayVerts();
-					glVertex3fv(pFltArray3);
-
-					// flip it
-					a[0] = -pFltV3Norm[0];
-					a[1] = -pFltV3Norm[1];
-					a[2] = -pFltV3Norm[2];
-					glNormal3fv(a);
-					glVertex3fv(pFltArray3);
-					a[0] = -pFltV2Norm[0];
-					a[1] = -pFltV2Norm[1];
-					a[2] = -pFltV2Norm[2];
-					glNormal3fv(a);
-					glVertex3fv(pFltArray2);
-					a[0] = -pFltV1Norm[0];
-					a[1] = -pFltV1Norm[1];
-					a[2] = -pFltV1Norm[2];
-					glNormal3fv(a);
-					glVertex3fv(pFltArray1);
-				}
-				else
-				{
-					const float* pFltArrayN = t.getNormal();
-					glNormal3fv(pFltArrayN);
-					const float* pFltArray1 = t.getVert1();
-					glVertex3fv(pFltArray1);
-					const float* pFltArray2 = t.getVert2();
-					glVertex3fv(pFltArray2);
-					const float* pFltArray3 = t.getVert3();
-					glVertex3fv(pFltArray3);
-		
-					a[0] = -pFltArrayN[0];
-					a[1] = -pFltArrayN[1];
-					a[2] = -pFltArrayN[2];
-					glNormal3fv(a);
-					glVertex3fv(pFltArray3);
-					glVertex3fv(pFltArray2);
-					glVertex3fv(pFltArray1);
-				}
-			}
+			glInterleavedArrays(GL_N3F_V3F, 0, g_pProgMesh->getSmoothVertexArray());
+			glDrawElements(GL_TRIANGLES, g_pProgMesh->numIndices(), GL_UNSIGNED_INT, 
+						   g_pProgMesh->getIndices());
+		}
+		else
+		{
+			glInterleavedArrays(GL_N3F_V3F, 0, g_pProgMesh->getFlatVertexArray());
+			glDrawArrays(GL_TRIANGLES, 0, 3 * g_pProgMesh->numVisTris());
 		}
-		glEnd();
 	}
 	
 	SwapBuffers(hDC_);
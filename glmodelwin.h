@@ -17,6 +17,11 @@ const float ORIG_DIST = 3.0f;
 const float MIN_DISTANCE = 0.1f;
 const float MAX_DISTANCE = 100.0f;
 
+// View-dependent refinement:  most a vertex can be off on the screen (in
+// pixels), & how long each frame refines the mesh
+const float VIEW_MAX_ERROR = 1.0f;
+const double VIEW_REFINE_SECONDS = 0.005;
+
 class glModelWindow
 {
 public:
@@ -27,7 +32,7 @@ public:
 						szAppName_("Mesh Simplication Demo by Jeff Somers"),
 						width_(0), height_(0), oldWidth_(0), oldHeight_(0),
 						oldX_(0), oldY_(0), newX_(0), newY_(0),
-						bFullScreen_(false), bFill_(true), bSmooth_(false)
+						bFullScreen_(false), bFill_(true), bSmooth_(false), bViewDependent_(false)
 	{
 		resetOrientation();
 	};
@@ -82,6 +87,11 @@ public:
 	bool isSmoothShadingMode() {return bSmooth_;};
 	void setSmoothShadingMode(bool newSmooth) {bSmooth_ = newSmooth;};
 
+	// The mesh may have one level of detail, or more detail where the
+	// view needs it (see PMesh::refineForView)
+	bool isViewDependentMode() {return bViewDependent_;};
+	void setViewDependentMode(bool newViewDependent) {bViewDependent_ = newViewDependent;};
+
 	// Display title text for window
 	void displayWindowTitle();
 
@@ -124,6 +134,9 @@ private:
 	// Use Gouraud shading?
 	bool bSmooth_;
 
+	// Refine the mesh for the view?
+	bool bViewDependent_;
+
 	// no assignment, copy ctor allowed (implementation not provided).
 	glModelWindow(const glModelWindow&);
 	glModelWindow& operator=(const glModelWindow&);
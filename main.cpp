@@ -159,6 +159,7 @@ int handleMenuCommands(WPARAM wParam, LPARAM lParam)
 		{
 			if (g_pProgMesh)
 			{
+				g_pWindow->setViewDependentMode(false);
 				bool ret = g_pProgMesh->splitVertex();
 				if (!ret) MessageBeep(0);
 				g_pWindow->displayWindowTitle();
@@ -170,6 +171,7 @@ int handleMenuCommands(WPARAM wParam, LPARAM lParam)
 		{
 			if (g_pProgMesh)
 			{
+				g_pWindow->setViewDependentMode(false);
 				bool ret = g_pProgMesh->collapseEdge();
 				if (!ret) MessageBeep(0);
 				g_pWindow->displayWindowTitle();
@@ -183,10 +185,8 @@ int handleMenuCommands(WPARAM wParam, LPARAM lParam)
 			{
 				int size = (g_pProgMesh->numEdgeCollapses()) / NUM_PAGEUPDN_INTERVALS;
 				if (size == 0) size = 1;
-				bool ret = true;
-				for (int i = 0; ret && i < size; ++i) {
-					 ret = g_pProgMesh->splitVertex();
-				}
+				g_pWindow->setViewDependentMode(false);
+				bool ret = g_pProgMesh->setCollapseIndex(g_pProgMesh->getCollapseIndex() - size);
 				if (!ret) MessageBeep(0);
 				g_pWindow->displayWindowTitle();
 				InvalidateRect(g_pWindow->getHWnd(), NULL, TRUE);
@@ -199,10 +199,8 @@ int handleMenuCommands(WPARAM wParam, LPARAM lParam)
 			{
 				int size = (g_pProgMesh->numEdgeCollapses()) / NUM_PAGEUPDN_INTERVALS;
 				if (size == 0) size = 1;
-				bool ret = true;
-				for (int i = 0; ret && i < size; ++i) {
-					 ret = g_pProgMesh->collapseEdge();
-				}
+				g_pWindow->setViewDependentMode(false);
+				bool ret = g_pProgMesh->setCollapseIndex(g_pProgMesh->getCollapseIndex() + size);
 				if (!ret) MessageBeep(0);
 				g_pWindow->displayWindowTitle();
 				InvalidateRect(g_pWindow->getHWnd(), NULL, TRUE);
@@ -500,6 +498,20 @@ LRESULT CALLBACK wndProc(HWND hWnd,	UINT uMsg, WPARAM wParam, LPARAM lParam)
 						InvalidateRect(g_pWindow->getHWnd(), NULL, TRUE);
 					}
 					return 0;
+				case 'v': // fall through
+				case 'V':
+					// switch view-dependent refinement on or off
+					if (g_pProgMesh)
+					{
+						g_pWindow->setViewDependentMode(!g_pWindow->isViewDependentMode());
+						if (!g_pWindow->isViewDependentMode())
+						{
+							g_pProgMesh->setCollapseIndex(g_pProgMesh->getCollapseIndex());
+						}
+						g_pWindow->displayWindowTitle();
+						InvalidateRect(g_pWindow->getHWnd(), NULL, TRUE);
+					}
+					return 0;
 				default:
 					break;
 				}
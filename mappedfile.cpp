@@ -0,0 +1,73 @@
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include "mappedfile.h"
+
+// Map the whole file into memory, read only.
+bool MappedFile::open(const char* filename)
+{
+	close();
+
+	_hFile = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+						OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == _hFile)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_hFile, &fileSize))
+	{
+		close();
+		return false;
+	}
+
+	if (0 == fileSize.QuadPart)
+	{
+		// Can't map an empty file, but there's nothing to read anyway.
+		return true;
+	}
+
+	_hMapping = CreateFileMapping(_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == _hMapping)
+	{
+		close();
+		return false;
+	}
+
+	_data = (const char*) MapViewOfFile(_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == _data)
+	{
+		close();
+		return false;
+	}
+	_size = (size_t) fileSize.QuadPart;
+	return true;
+}
+
+// Unmap the file & release the handles
+void MappedFile::close()
+{
+	if (_data)
+	{
+		UnmapViewOfFile(_data);
+		_data = NULL;
+	}
+	_size = 0;
+
+	if (_hMapping)
+	{
+		CloseHandle(_hMapping);
+		_hMapping = NULL;
+	}
+
+	if (INVALID_HANDLE_VALUE != _hFile)
+	{
+		CloseHandle(_hFile);
+		_hFile = INVALID_HANDLE_VALUE;
+	}
+}
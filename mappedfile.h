@@ -0,0 +1,48 @@
+#ifndef __mappedfile_h
+#define __mappedfile_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include <stddef.h>
+
+// Read-only view of an entire file, mapped into memory.  The mesh
+// loader uses this so it can decode the vertex & face blocks of a
+// PLY file in place, rather than reading them one token at a time
+// through stdio.
+class MappedFile
+{
+public:
+	MappedFile() : _hFile(INVALID_HANDLE_VALUE), _hMapping(NULL),
+					_data(NULL), _size(0) {};
+	~MappedFile() {close();};
+
+	// Map the whole file.  Returns false if the file can't be opened
+	// or mapped.  An empty file maps successfully with a size of 0.
+	bool open(const char* filename);
+
+	// Unmap the file (called automatically by the destructor)
+	void close();
+
+	const char* getData() const {return _data;}
+	size_t getSize() const {return _size;}
+
+private:
+	HANDLE _hFile;
+	HANDLE _hMapping;
+	const char* _data; // first byte of the file
+	size_t _size; // size of the file in bytes
+
+	// no assignment, copy ctor allowed (implementation not provided).
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif // __mappedfile_h
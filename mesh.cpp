@@ -12,6 +12,21 @@
 #include <float.h>
 #include <iostream>
 
+#include "mappedfile.h"
+#include "adjacency.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined (_MSC_VER)
+typedef __int64 int64;
+typedef unsigned __int64 uint64;
+#else
+typedef long long int64;
+typedef unsigned long long uint64;
+#endif
+
 
 Mesh::Mesh(char* filename)
 {
@@ -20,8 +35,11 @@ Mesh::Mesh(char* filename)
 	{
 		// we failed to load mesh from the file
 		_numVerts = _numTriangles = 0;
-		_vlist.clear();
+		_verts.clear();
 		_plist.clear();
+		_vertNeighbors.clear();
+		_triNeighbors.clear();
+		_corners.clear();
 	}
 }
 
@@ -29,9 +47,12 @@ Mesh::Mesh(const Mesh& m)
 {
 	_numVerts = m._numVerts;
 	_numTriangles = m._numTriangles;
-	_vlist = m._vlist; // NOTE: triangles are still pointing to original mesh
+	_verts = m._verts;
 	_plist = m._plist;
-	// NOTE: should reset tris in _vlist, _plist
+	_vertNeighbors = m._vertNeighbors;
+	_triNeighbors = m._triNeighbors;
+	_corners = m._corners;
+	pointTrisToThis();
 }
 
 Mesh& Mesh::operator=(const Mesh& m)
@@ -39,16 +60,29 @@ Mesh& Mesh::operator=(const Mesh& m)
 	if (this == &m) return *this; // don't assign to self
 	_numVerts = m._numVerts;
 	_numTriangles = m._numTriangles;
-	_vlist = m._vlist; // NOTE: triangles are still pointing to original mesh
+	_verts = m._verts;
 	_plist = m._plist;
-	// NOTE: should reset tris in _vlist, _plist
+	_vertNeighbors = m._vertNeighbors;
+	_triNeighbors = m._triNeighbors;
+	_corners = m._corners;
+	pointTrisToThis();
 	return *this;
 }
 
+// The copied triangles still point to the other mesh, so their normals
+// & areas would be calculated from its vertices
+void Mesh::pointTrisToThis()
+{
+	for (unsigned i = 0; i < _plist.size(); ++i)
+	{
+		_plist[i].changeMesh(this);
+	}
+}
+
 Mesh::~Mesh()
 {
 	_numVerts = _numTriangles = 0;
-	_vlist.erase(_vlist.begin(), _vlist.end());
+	_verts.clear();
 	_plist.erase(_plist.begin(), _plist.end());
 }
 
@@ -188,6 +222,8 @@ bool Mesh::readPlyHeader(FILE *&inFile)
 bool Mesh::readPlyVerts(FILE *&inFile)
 {
 	int i;
+	_verts.resize(_numVerts);
+
 	// read vertices
 	for ( i = 0; i < _numVerts; i++)
 	{
@@ -202,10 +238,9 @@ bool Mesh::readPlyVerts(FILE *&inFile)
 		float z = atof(tempStr); 
 #pragma warning(default:4244)		/* double -> float */
 
-		vertex v(x, y, z);//vertex󲢵ù캯vertex(float x,float y,float z)гʼ
-		v.setIndex(i);//övsetIndex
-
-		_vlist.push_back(v); // push_back puts a *copy* of the element at the end of the list
+		vertex v = getVertex(i);
+		v.getXYZ() = Vec3(x, y, z);
+		v.setActive(true);
 		if (feof(inFile))
 		{
 			MessageBox(NULL,"Reached End of File before all vertices found!\n",
@@ -247,19 +282,6 @@ bool Mesh::readPlyTris(FILE *&inFile)
 
 		_plist.push_back(t); // push_back puts a *copy* of the element at the end of the list
 
-		// update each vertex w/ its neighbors (vertrices & triangles)
-		_vlist[v1].addTriNeighbor(i);
-		_vlist[v1].addVertNeighbor(v2);
-		_vlist[v1].addVertNeighbor(v3);
-
-		_vlist[v2].addTriNeighbor(i);
-		_vlist[v2].addVertNeighbor(v1);
-		_vlist[v2].addVertNeighbor(v3);
-
-		_vlist[v3].addTriNeighbor(i);
-		_vlist[v3].addVertNeighbor(v1);
-		_vlist[v3].addVertNeighbor(v2);
-
 		if (feof(inFile))
 		{
 			MessageBox(NULL, "Reached End of File before all faces found!\n",
@@ -272,10 +294,717 @@ bool Mesh::readPlyTris(FILE *&inFile)
 	return true;
 }
 
+// Size in bytes of a PLY scalar type
+static int plyTypeSize(PlyLayout::Type type)
+{
+	switch (type)
+	{
+	case PlyLayout::INT8: // deliberate fall through
+	case PlyLayout::UINT8:
+		return 1;
+	case PlyLayout::INT16: // deliberate fall through
+	case PlyLayout::UINT16:
+		return 2;
+	case PlyLayout::INT32: // deliberate fall through
+	case PlyLayout::UINT32: // deliberate fall through
+	case PlyLayout::FLOAT32:
+		return 4;
+	case PlyLayout::FLOAT64:
+		return 8;
+	default:
+		return 0;
+	};
+}
+
+// Convert a PLY type name (already in lower case) to a type.
+// Both the original names ("uchar") & the sized names ("uint8") are allowed.
+static PlyLayout::Type plyTypeFromName(const char* name)
+{
+	if (!strcmp(name, "char") || !strcmp(name, "int8")) return PlyLayout::INT8;
+	if (!strcmp(name, "uchar") || !strcmp(name, "uint8")) return PlyLayout::UINT8;
+	if (!strcmp(name, "short") || !strcmp(name, "int16")) return PlyLayout::INT16;
+	if (!strcmp(name, "ushort") || !strcmp(name, "uint16")) return PlyLayout::UINT16;
+	if (!strcmp(name, "int") || !strcmp(name, "int32")) return PlyLayout::INT32;
+	if (!strcmp(name, "uint") || !strcmp(name, "uint32")) return PlyLayout::UINT32;
+	if (!strcmp(name, "float") || !strcmp(name, "float32")) return PlyLayout::FLOAT32;
+	if (!strcmp(name, "double") || !strcmp(name, "float64")) return PlyLayout::FLOAT64;
+	return PlyLayout::NO_TYPE;
+}
+
+// Copy one binary scalar out of the file, swapping the bytes if the
+// file's byte order doesn't match the machine's.
+static void readPlyBytes(const char* p, int size, bool bSwap, unsigned char out[8])
+{
+	memcpy(out, p, size); // the records aren't aligned, so copy first
+	if (bSwap)
+	{
+		for (int i = 0; i < size / 2; ++i)
+		{
+			unsigned char c = out[i];
+			out[i] = out[size - 1 - i];
+			out[size - 1 - i] = c;
+		}
+	}
+}
+
+// Decode one binary scalar as a float (used for vertex coordinates)
+static float readPlyFloat(const char* p, PlyLayout::Type type, bool bSwap)
+{
+	unsigned char buf[8];
+	readPlyBytes(p, plyTypeSize(type), bSwap, buf);
+	switch (type)
+	{
+	case PlyLayout::INT8:		return (float) *(signed char*) buf;
+	case PlyLayout::UINT8:		return (float) *(unsigned char*) buf;
+	case PlyLayout::INT16:		return (float) *(short*) buf;
+	case PlyLayout::UINT16:		return (float) *(unsigned short*) buf;
+	case PlyLayout::INT32:		return (float) *(int*) buf;
+	case PlyLayout::UINT32:		return (float) *(unsigned int*) buf;
+	case PlyLayout::FLOAT32:	return *(float*) buf;
+	case PlyLayout::FLOAT64:	return (float) *(double*) buf;
+	default:					return 0;
+	};
+}
+
+// Decode one binary scalar as an integer (used for vertex indices).
+// Values which don't fit in an int are returned as -1.
+static int readPlyInt(const char* p, PlyLayout::Type type, bool bSwap)
+{
+	unsigned char buf[8];
+	readPlyBytes(p, plyTypeSize(type), bSwap, buf);
+	switch (type)
+	{
+	case PlyLayout::INT8:		return *(signed char*) buf;
+	case PlyLayout::UINT8:		return *(unsigned char*) buf;
+	case PlyLayout::INT16:		return *(short*) buf;
+	case PlyLayout::UINT16:		return *(unsigned short*) buf;
+	case PlyLayout::INT32:		return *(int*) buf;
+	case PlyLayout::UINT32:
+		{
+			unsigned int u = *(unsigned int*) buf;
+			return (u > 0x7fffffff) ? -1 : (int) u;
+		}
+	default:					return -1; // floating point indices aren't allowed
+	};
+}
+
+// Is this machine little endian?
+static bool isLittleEndianMachine()
+{
+	const unsigned short one = 1;
+	return (1 == *(const unsigned char*) &one);
+}
+
+// Helper function for reading PLY mesh file.  Parse the header of
+// a memory mapped PLY file, to find the format of the file, the number
+// of vertices & triangles, and where the coordinates & vertex indices
+// are stored in each record.
+bool Mesh::readPlyLayout(const MappedFile& file, PlyLayout& layout)
+{
+	enum {NO_ELEMENT, VERTEX_ELEMENT, FACE_ELEMENT, OTHER_ELEMENT};
+
+	const char* data = file.getData();
+	const size_t size = file.getSize();
+
+	memset(&layout, 0, sizeof(layout));
+	layout.format = PlyLayout::ASCII;
+
+	int element = NO_ELEMENT;
+	int otherCount = 0; // # of records in an element we don't use
+	int otherSize = 0; // size of each record in that element
+	bool bVertexFound = false;
+	bool bFaceFound = false;
+	bool bFaceListFound = false;
+	bool bHeaderEnded = false;
+	int lineNum = 0;
+
+	size_t pos = 0;
+	while (pos < size)
+	{
+		// get the next line of the header
+		size_t eol = pos;
+		while (eol < size && data[eol] != '\n') ++eol;
+
+		char line[1024];
+		size_t len = eol - pos;
+		if (len >= sizeof(line)) len = sizeof(line) - 1;
+		memcpy(line, data + pos, len);
+		line[len] = '\0';
+		pos = (eol < size) ? eol + 1 : size;
+
+		ChangeStrToLower(line);
+
+		char tok[5][256];
+		int nTok = sscanf(line, "%255s %255s %255s %255s %255s", tok[0], tok[1], tok[2], tok[3], tok[4]);
+		if (nTok <= 0) continue;
+
+		if (0 == lineNum++)
+		{
+			if (strcmp(tok[0], "ply"))
+			{
+				MessageBox(NULL, "The string \"ply\" NOT FOUND at the start of the file!\n",
+					NULL, MB_ICONEXCLAMATION);
+				return false;
+			}
+			continue;
+		}
+
+		if (!strcmp(tok[0], "end_header"))
+		{
+			bHeaderEnded = true;
+			break;
+		}
+		else if (!strcmp(tok[0], "format") && nTok >= 2)
+		{
+			if (!strcmp(tok[1], "binary_little_endian")) layout.format = PlyLayout::BINARY_LITTLE_ENDIAN;
+			else if (!strcmp(tok[1], "binary_big_endian")) layout.format = PlyLayout::BINARY_BIG_ENDIAN;
+			else layout.format = PlyLayout::ASCII;
+		}
+		else if (!strcmp(tok[0], "element") && nTok >= 3)
+		{
+			// Records of elements before the vertices are skipped, as
+			// long as they're a fixed size.
+			if (OTHER_ELEMENT == element && !bVertexFound)
+			{
+				layout.vertexStart += (size_t) otherCount * otherSize;
+			}
+
+			if (!strcmp(tok[1], "vertex"))
+			{
+				element = VERTEX_ELEMENT;
+				bVertexFound = true;
+				_numVerts = atoi(tok[2]);
+			}
+			else if (!strcmp(tok[1], "face"))
+			{
+				element = FACE_ELEMENT;
+				bFaceFound = true;
+				_numTriangles = atoi(tok[2]);
+			}
+			else
+			{
+				if (bVertexFound && !bFaceFound && PlyLayout::ASCII != layout.format)
+				{
+					MessageBox(NULL, "Error:  Binary ply files with elements between the vertices & faces are not supported!\n",
+						NULL, MB_ICONEXCLAMATION);
+					return false;
+				}
+				element = OTHER_ELEMENT;
+				otherCount = atoi(tok[2]);
+				otherSize = 0;
+			}
+		}
+		else if (!strcmp(tok[0], "property") && nTok >= 3)
+		{
+			if (!strcmp(tok[1], "list"))
+			{
+				if (FACE_ELEMENT == element && nTok >= 5 && !bFaceListFound &&
+					(!strcmp(tok[4], "vertex_indices") || !strcmp(tok[4], "vertex_index")))
+				{
+					layout.faceCountType = plyTypeFromName(tok[2]);
+					layout.faceIndexType = plyTypeFromName(tok[3]);
+					bFaceListFound = true;
+				}
+				else if (PlyLayout::ASCII != layout.format && !(OTHER_ELEMENT == element && bFaceFound))
+				{
+					MessageBox(NULL, "Error:  Binary ply files with lists outside of the faces are not supported!\n",
+						NULL, MB_ICONEXCLAMATION);
+					return false;
+				}
+				continue;
+			}
+
+			PlyLayout::Type type = plyTypeFromName(tok[1]);
+			int typeSize = plyTypeSize(type);
+			if (PlyLayout::NO_TYPE == type && PlyLayout::ASCII != layout.format)
+			{
+				MessageBox(NULL, "Error:  Ply file contains a property of unknown type!\n",
+					NULL, MB_ICONEXCLAMATION);
+				return false;
+			}
+
+			if (VERTEX_ELEMENT == element)
+			{
+				int coord = -1;
+				if (!strcmp(tok[2], "x")) coord = 0;
+				else if (!strcmp(tok[2], "y")) coord = 1;
+				else if (!strcmp(tok[2], "z")) coord = 2;
+				if (coord >= 0)
+				{
+					layout.xyzOffset[coord] = layout.vertexSize;
+					layout.xyzType[coord] = type;
+				}
+				layout.vertexSize += typeSize;
+			}
+			else if (FACE_ELEMENT == element)
+			{
+				if (bFaceListFound) layout.faceSuffixSize += typeSize;
+				else layout.facePrefixSize += typeSize;
+			}
+			else
+			{
+				otherSize += typeSize;
+			}
+		}
+	}
+
+	if (!bHeaderEnded)
+	{
+		MessageBox(NULL, TEXT("Reached End of File and string \"end_header\" not found!\n"),
+			NULL, MB_ICONEXCLAMATION);
+		return false;
+	}
+	layout.headerSize = pos;
+
+	if (!bVertexFound || !bFaceFound)
+	{
+		MessageBox(NULL, "Ply file does not contain both \"element vertex\" & \"element face\"!\n",
+			NULL, MB_ICONEXCLAMATION);
+		return false;
+	}
+
+	if (PlyLayout::ASCII != layout.format)
+	{
+		if (!layout.xyzType[0] || !layout.xyzType[1] || !layout.xyzType[2])
+		{
+			MessageBox(NULL, "Error:  Ply file vertices do not have x, y & z properties!\n",
+				NULL, MB_ICONEXCLAMATION);
+			return false;
+		}
+		if (!bFaceListFound || PlyLayout::FLOAT32 == layout.faceCountType ||
+			PlyLayout::FLOAT64 == layout.faceCountType ||
+			PlyLayout::FLOAT32 == layout.faceIndexType ||
+			PlyLayout::FLOAT64 == layout.faceIndexType)
+		{
+			MessageBox(NULL, "Error:  Ply file faces do not have an integer list of vertex indices!\n",
+				NULL, MB_ICONEXCLAMATION);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Helper function for reading binary PLY mesh file.  The vertices are
+// decoded straight from the mapped file into the vertex list.
+bool Mesh::readBinaryPlyVerts(const char* body, size_t bodySize, const PlyLayout& layout)
+{
+	const bool bSwap = ((PlyLayout::BINARY_LITTLE_ENDIAN == layout.format) != isLittleEndianMachine());
+
+	if (_numVerts < 0 ||
+		layout.vertexStart + (size_t) _numVerts * layout.vertexSize > bodySize)
+	{
+		MessageBox(NULL,"Reached End of File before all vertices found!\n",
+			NULL, MB_ICONEXCLAMATION);
+		return false;
+	}
+
+	_verts.resize(_numVerts);
+
+	const char* rec = body + layout.vertexStart;
+	for (int i = 0; i < _numVerts; ++i, rec += layout.vertexSize)
+	{
+		vertex v = getVertex(i);
+		v.getXYZ() = Vec3(readPlyFloat(rec + layout.xyzOffset[0], layout.xyzType[0], bSwap),
+						  readPlyFloat(rec + layout.xyzOffset[1], layout.xyzType[1], bSwap),
+						  readPlyFloat(rec + layout.xyzOffset[2], layout.xyzType[2], bSwap));
+		v.setActive(true);
+	}
+	return true;
+}
+
+// Helper function for reading binary PLY mesh file.  The triangles are
+// decoded straight from the mapped file into the triangle list.
+bool Mesh::readBinaryPlyTris(const char* body, size_t bodySize, const PlyLayout& layout)
+{
+	const bool bSwap = ((PlyLayout::BINARY_LITTLE_ENDIAN == layout.format) != isLittleEndianMachine());
+	const int countSize = plyTypeSize(layout.faceCountType);
+	const int indexSize = plyTypeSize(layout.faceIndexType);
+	const int recSize = layout.facePrefixSize + countSize + 3 * indexSize + layout.faceSuffixSize;
+
+	size_t pos = layout.vertexStart + (size_t) _numVerts * layout.vertexSize;
+	if (_numTriangles < 0 ||
+		pos + (size_t) _numTriangles * recSize > bodySize)
+	{
+		MessageBox(NULL, "Reached End of File before all faces found!\n",
+			NULL, MB_ICONEXCLAMATION);
+		return false;
+	}
+
+	_plist.resize(_numTriangles);
+
+	const char* rec = body + pos;
+	for (int i = 0; i < _numTriangles; ++i, rec += recSize)
+	{
+		const char* p = rec + layout.facePrefixSize;
+		if (3 != readPlyInt(p, layout.faceCountType, bSwap))
+		{
+			MessageBox(NULL, "Error:  Ply file contains polygons which are not triangles!\n",
+				NULL, MB_ICONEXCLAMATION);
+			return false;
+		}
+		p += countSize;
+		int v1 = readPlyInt(p, layout.faceIndexType, bSwap);
+		int v2 = readPlyInt(p + indexSize, layout.faceIndexType, bSwap);
+		int v3 = readPlyInt(p + 2 * indexSize, layout.faceIndexType, bSwap);
+
+		// make sure verts in correct range
+		if (v1 < 0 || v2 < 0 || v3 < 0 ||
+			v1 >= _numVerts || v2 >= _numVerts || v3 >= _numVerts)
+		{
+			MessageBox(NULL, "Error:  Ply file contains a face with an invalid vertex index!\n",
+				NULL, MB_ICONEXCLAMATION);
+			return false;
+		}
+
+		_plist[i] = triangle(this, v1, v2, v3);
+		_plist[i].setIndex(i);
+	}
+	return true;
+}
+
+
+// Characters which separate tokens on a line of an ASCII PLY file
+static inline bool isPlySpace(char c)
+{
+	return (' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c);
+}
+
+// Find the end of the token starting at p
+static inline const char* plyTokenEnd(const char* p, const char* end)
+{
+	while (p < end && '\n' != *p && !isPlySpace(*p)) ++p;
+	return p;
+}
+
+// Parse one floating point token from an ASCII PLY file, giving exactly
+// what atof() would.  Numbers w/ at most 19 significant digits, whose
+// mantissa fits in a double & whose exponent is small enough that the
+// power of 10 is exact, are converted w/ a single multiply or divide,
+// which is correctly rounded.  Anything else is handed to atof().
+static bool parsePlyFloat(const char*& p, const char* end, float& out)
+{
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	while (p < end && isPlySpace(*p)) ++p;
+	if (p >= end || '\n' == *p) return false; // no more tokens on this line
+
+	const char* tokenEnd = plyTokenEnd(p, end);
+	const char* q = p;
+
+	bool bNegative = false;
+	if ('-' == *q || '+' == *q)
+	{
+		bNegative = ('-' == *q);
+		++q;
+	}
+
+	uint64 mantissa = 0;
+	int nDigits = 0; // significant digits in mantissa
+	int exponent = 0;
+	bool bDigitFound = false;
+	bool bFastPath = true;
+
+	for (; q < tokenEnd && *q >= '0' && *q <= '9'; ++q)
+	{
+		bDigitFound = true;
+		if (0 == mantissa && '0' == *q) continue; // leading zero
+		if (nDigits < 19) {mantissa = mantissa * 10 + (*q - '0'); ++nDigits;}
+		else {bFastPath = false;}
+	}
+	if (q < tokenEnd && '.' == *q)
+	{
+		for (++q; q < tokenEnd && *q >= '0' && *q <= '9'; ++q)
+		{
+			bDigitFound = true;
+			if (0 == mantissa && '0' == *q) {--exponent; continue;}
+			if (nDigits < 19) {mantissa = mantissa * 10 + (*q - '0'); ++nDigits; --exponent;}
+			else {bFastPath = false;}
+		}
+	}
+	if (bDigitFound && q < tokenEnd && ('e' == *q || 'E' == *q))
+	{
+		++q;
+		bool bNegExp = false;
+		if (q < tokenEnd && ('-' == *q || '+' == *q))
+		{
+			bNegExp = ('-' == *q);
+			++q;
+		}
+		int e = 0;
+		bool bExpDigit = false;
+		for (; q < tokenEnd && *q >= '0' && *q <= '9'; ++q)
+		{
+			bExpDigit = true;
+			if (e < 10000) e = e * 10 + (*q - '0');
+		}
+		if (!bExpDigit) bFastPath = false;
+		exponent += bNegExp ? -e : e;
+	}
+
+	double value;
+	if (bFastPath && bDigitFound && q == tokenEnd &&
+		mantissa <= ((uint64) 1 << 53) && exponent >= -22 && exponent <= 22)
+	{
+		value = (double) (int64) mantissa; // mantissa <= 2^53, so the signed conversion is exact
+		if (exponent < 0) value /= pow10[-exponent];
+		else value *= pow10[exponent];
+		if (bNegative) value = -value;
+	}
+	else
+	{
+		char tempStr[1024];
+		size_t len = tokenEnd - p;
+		if (len >= sizeof(tempStr)) len = sizeof(tempStr) - 1;
+		memcpy(tempStr, p, len);
+		tempStr[len] = '\0';
+		value = atof(tempStr);
+	}
+
+#pragma warning(disable:4244)		/* disable double -> float warning */
+	out = value;
+#pragma warning(default:4244)		/* double -> float */
+
+	p = tokenEnd;
+	return true;
+}
+
+// Parse one integer token from an ASCII PLY file.
+static bool parsePlyInt(const char*& p, const char* end, int& out)
+{
+	while (p < end && isPlySpace(*p)) ++p;
+
+	const char* q = p;
+	bool bNegative = false;
+	if (q < end && ('-' == *q || '+' == *q))
+	{
+		bNegative = ('-' == *q);
+		++q;
+	}
+
+	const char* digits = q;
+	int value = 0;
+	for (; q < end && *q >= '0' && *q <= '9'; ++q)
+	{
+		if (value > 0x7fffffff / 10 - 1) return false; // too big
+		value = value * 10 + (*q - '0');
+	}
+	if (q == digits || q != plyTokenEnd(q, end)) return false; // not an integer
+
+	out = bNegative ? -value : value;
+	p = q;
+	return true;
+}
+
+// Skip past the end of the current line
+static inline const char* plyNextLine(const char* p, const char* end)
+{
+	while (p < end && '\n' != *p) ++p;
+	return (p < end) ? p + 1 : end;
+}
+
+// Is the line starting at p all white space?
+static inline bool isPlyBlankLine(const char* p, const char* end)
+{
+	while (p < end && isPlySpace(*p)) ++p;
+	return (p >= end || '\n' == *p);
+}
+
+// Helper function for reading ASCII PLY mesh file.  The body is split into
+// line-aligned chunks.  Each chunk's lines are counted, then (once we know
+// which record each chunk starts with) parsed, in parallel, into arrays of
+// coordinates & vertex indices.  The vertex & triangle lists are built from
+// those arrays.
+bool Mesh::readAsciiPlyBody(const char* body, size_t bodySize)
+{
+	const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+	if (_numVerts < 0 || _numTriangles < 0) return false;
+
+	int nChunks = 1;
+#ifdef _OPENMP
+	nChunks = 4 * omp_get_max_threads(); // a few chunks per thread to balance the load
+#endif
+	if ((size_t) nChunks > bodySize / MIN_CHUNK_SIZE) nChunks = (int) (bodySize / MIN_CHUNK_SIZE);
+	if (nChunks < 1) nChunks = 1;
+
+	// Chunk k is [chunkStart[k], chunkStart[k + 1]).  Each chunk starts at
+	// the beginning of a line.
+	vector<size_t> chunkStart(nChunks + 1);
+	chunkStart[0] = 0;
+	chunkStart[nChunks] = bodySize;
+	int k;
+	for (k = 1; k < nChunks; ++k)
+	{
+		size_t pos = bodySize / nChunks * k;
+		if (pos < chunkStart[k - 1]) pos = chunkStart[k - 1];
+		chunkStart[k] = plyNextLine(body + pos, body + bodySize) - body;
+	}
+
+	// Count the records (non-blank lines) in each chunk
+	vector<int> firstRecord(nChunks + 1, 0);
+#pragma omp parallel for schedule(dynamic)
+	for (k = 0; k < nChunks; ++k)
+	{
+		const char* p = body + chunkStart[k];
+		const char* end = body + chunkStart[k + 1];
+		int nRecords = 0;
+		for (; p < end; p = plyNextLine(p, end))
+		{
+			if (!isPlyBlankLine(p, end)) ++nRecords;
+		}
+		firstRecord[k + 1] = nRecords;
+	}
+
+	for (k = 0; k < nChunks; ++k)
+	{
+		firstRecord[k + 1] += firstRecord[k];
+	}
+
+	if (firstRecord[nChunks] < _numVerts + _numTriangles)
+	{
+		return false; // records are split across lines, or the file is short
+	}
+
+	// Parse the records straight into pre-sized arrays
+	vector<float> coords(3 * (size_t) _numVerts);
+	vector<int> indices(3 * (size_t) _numTriangles);
+	vector<int> chunkFailed(nChunks, 0);
+
+#pragma omp parallel for schedule(dynamic)
+	for (k = 0; k < nChunks; ++k)
+	{
+		const char* p = body + chunkStart[k];
+		const char* end = body + chunkStart[k + 1];
+		int rec = firstRecord[k];
+		for (; p < end && rec < _numVerts + _numTriangles; p = plyNextLine(p, end))
+		{
+			if (isPlyBlankLine(p, end)) continue;
+
+			const char* q = p;
+			if (rec < _numVerts)
+			{
+				float* xyz = &coords[3 * (size_t) rec];
+				if (!parsePlyFloat(q, end, xyz[0]) ||
+					!parsePlyFloat(q, end, xyz[1]) ||
+					!parsePlyFloat(q, end, xyz[2]))
+				{
+					chunkFailed[k] = 1;
+					break;
+				}
+			}
+			else
+			{
+				int* v = &indices[3 * (size_t) (rec - _numVerts)];
+				int nVerts;
+				if (!parsePlyInt(q, end, nVerts) || 3 != nVerts ||
+					!parsePlyInt(q, end, v[0]) ||
+					!parsePlyInt(q, end, v[1]) ||
+					!parsePlyInt(q, end, v[2]) ||
+					v[0] < 0 || v[0] >= _numVerts ||
+					v[1] < 0 || v[1] >= _numVerts ||
+					v[2] < 0 || v[2] >= _numVerts)
+				{
+					chunkFailed[k] = 1;
+					break;
+				}
+			}
+			++rec;
+		}
+	}
+
+	for (k = 0; k < nChunks; ++k)
+	{
+		if (chunkFailed[k]) return false;
+	}
+
+	// Build the vertex & triangle lists from the arrays
+	int i;
+	_verts.resize(_numVerts);
+#pragma omp parallel for
+	for (i = 0; i < _numVerts; ++i)
+	{
+		vertex v = getVertex(i);
+		v.getXYZ() = Vec3(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+		v.setActive(true);
+	}
+
+	_plist.resize(_numTriangles);
+#pragma omp parallel for
+	for (i = 0; i < _numTriangles; ++i)
+	{
+		_plist[i] = triangle(this, indices[3 * i], indices[3 * i + 1], indices[3 * i + 2]);
+		_plist[i].setIndex(i);
+	}
+	return true;
+}
+
 
 // Load mesh from PLY file
 bool Mesh::loadFromFile(char* filename)
 {
+	// Map the file, so we can see what format it's in.  Binary files
+	// are decoded directly from the mapped memory.
+	{
+		MappedFile mappedFile;
+		if (!mappedFile.open(filename))
+		{
+			char pszError[_MAX_FNAME + 1];
+			sprintf(pszError, "%s does not exist!\n", filename);
+			MessageBox(NULL, pszError, NULL, MB_ICONEXCLAMATION);
+			return false;
+		}
+
+		PlyLayout layout;
+		if (!readPlyLayout(mappedFile, layout))
+		{
+			return false;
+		}
+
+		const char* body = mappedFile.getData() + layout.headerSize;
+		const size_t bodySize = mappedFile.getSize() - layout.headerSize;
+
+		if (PlyLayout::ASCII == layout.format)
+		{
+			// Parse the body in parallel.  If it's laid out in a way the
+			// chunked parser doesn't handle (e.g. a record split across lines,
+			// or an error in the file), use the stdio readers below, which
+			// also report the error.
+			if (readAsciiPlyBody(body, bodySize))
+			{
+				buildAdjacency();
+				calcVertNormals();
+
+				return true;
+			}
+			_verts.clear();
+			_plist.clear();
+		}
+		else
+		{
+			// read vertex data from PLY file
+			if (!readBinaryPlyVerts(body, bodySize, layout))
+			{
+				return false;
+			}
+
+			// read triangle data from PLY file
+			if (!readBinaryPlyTris(body, bodySize, layout))
+			{
+				return false;
+			}
+
+			buildAdjacency();
+			calcVertNormals();
+
+			return true;
+		}
+	}
+
+	// Read the ASCII file w/ stdio
+	_numVerts = _numTriangles = 0;
     FILE* inFile = fopen(filename, "rt");
     if (inFile == NULL)
     {
@@ -305,30 +1034,89 @@ bool Mesh::loadFromFile(char* filename)
 
     fclose(inFile); // close the file
 
+	buildAdjacency();
 	calcVertNormals();
 
 	return true;
 }
 
 
+// Find the neighbors (vertices & triangles) of each vertex, once all
+// the triangles have been read.  The adjacency is built for the whole
+// mesh at once, w/ a parallel counting sort, and then copied into the
+// mutable adjacency w/ a little room in each row for edge collapses.
+// The corner table is built from the triangle neighbors.
+void Mesh::buildAdjacency()
+{
+	int i;
+	vector<int> faces(3 * (size_t) _numTriangles);
+
+#pragma omp parallel for
+	for (i = 0; i < _numTriangles; ++i)
+	{
+		_plist[i].getVerts(faces[3 * i], faces[3 * i + 1], faces[3 * i + 2]);
+	}
+
+	const int* pFaces = faces.empty() ? 0 : &faces[0];
+
+	CSRAdjacency vertTris;
+	vertTris.buildVertTris(pFaces, _numTriangles, _numVerts);
+
+	CSRAdjacency vertNeighbors;
+	vertNeighbors.buildVertNeighbors(pFaces, vertTris);
+
+	_triNeighbors.assign(vertTris, ADJACENCY_SLACK);
+	_vertNeighbors.assign(vertNeighbors, ADJACENCY_SLACK);
+
+	_corners.build(*this);
+}
+
+
+// The vertex normals are recalculated, since adding up the normals of
+// the triangles in another order can round differently.  (Then they're
+// the same as when they're recalculated after edge collapses.)
+void Mesh::renumber(const vector<int>& newVert, const vector<int>& newTri)
+{
+	int i;
+	_verts.renumber(newVert);
+
+	vector<triangle> plist(_plist.size());
+#pragma omp parallel for
+	for (i = 0; i < _numTriangles; ++i)
+	{
+		triangle& t = plist[newTri[i]];
+		t = _plist[i];
+		t.setVerts(newVert[t.getVert1Index()], newVert[t.getVert2Index()], newVert[t.getVert3Index()]);
+		t.setIndex(newTri[i]);
+		t.changeMesh(this);
+	}
+	_plist.swap(plist);
+
+	buildAdjacency();
+	calcVertNormals();
+}
+
+
 // Recalculate the normal for one vertex
 void Mesh::calcOneVertNormal(unsigned vert)
 {
-	vertex& v = getVertex(vert);
-	const set<int>& triset = v.getTriNeighbors();
+	const AdjacencyRow triset = getTriNeighbors(vert);
 
-	set<int>::const_iterator iter;
+	const int* iter;
 
 	Vec3 vec;
 
 	for (iter = triset.begin(); iter != triset.end(); ++iter)
 	{
 		// get the triangles for each vertex & add up the normals.
-		vec += getTri(*iter).getNormalVec3();
+		// (When edge collapses are played back, the hidden triangles are
+		// still neighbors, but their normals may be out of date.)
+		const triangle& t = getTri(*iter);
+		if (t.isActive()) vec += t.getNormalVec3();
 	}
 
 	vec.normalize(); // normalize the vertex	
-	v.setVertNomal(vec);
+	getVertex(vert).setVertNomal(vec);
 }
 
 
@@ -336,7 +1124,7 @@ void Mesh::calcOneVertNormal(unsigned vert)
 void Mesh::calcVertNormals()
 {
 	// Iterate through the vertices
-	for (unsigned i = 0; i < _vlist.size(); ++i)
+	for (int i = 0; i < _verts.size(); ++i)
 	{
 		calcOneVertNormal(i);
 	}
@@ -349,9 +1137,21 @@ void Mesh::dump()
 	std::cout << "*** Mesh Dump ***" << std::endl;
 	std::cout << "# of vertices: " << _numVerts << std::endl;
 	std::cout << "# of triangles: " << _numTriangles << std::endl;
-	for (unsigned i = 0; i < _vlist.size(); ++i)
+	for (int i = 0; i < _verts.size(); ++i)
 	{
-		std::cout << "\tVertex " << i << ": " << _vlist[i] << std::endl;
+		std::cout << "\tVertex " << i << ": " << getVertex(i);
+		const int* pos;
+		std::cout << " Vert Neighbors:";
+		for (pos = getVertNeighbors(i).begin(); pos != getVertNeighbors(i).end(); ++pos)
+		{
+			std::cout << " " << *pos;
+		}
+		std::cout << " Tri Neighbors:";
+		for (pos = getTriNeighbors(i).begin(); pos != getTriNeighbors(i).end(); ++pos)
+		{
+			std::cout << " " << *pos;
+		}
+		std::cout << std::endl;
 	}
 	std::cout << std::endl;
 	for (unsigned i = 0; i < _plist.size(); ++i)
@@ -368,9 +1168,10 @@ void Mesh::setMinMax(float min[3], float max[3])
 	max[0] = max[1] = max[2] = -FLT_MAX;
 	min[0] = min[1] = min[2] = FLT_MAX;
 
-	for (unsigned int i = 0; i < _vlist.size(); ++i)
+	const Vec3* positions = _verts.getPositions();
+	for (int i = 0; i < _verts.size(); ++i)
 	{
-		const float* pVert = _vlist[i].getArrayVerts();
+		const float* pVert = &positions[i].x;
 		if (pVert[0] < min[0]) min[0] = pVert[0];
 		if (pVert[1] < min[1]) min[1] = pVert[1];
 		if (pVert[2] < min[2]) min[2] = pVert[2];
@@ -401,10 +1202,11 @@ void Mesh::Normalize()
 
 	transv *= 0.5f;
 
-	for (unsigned int i = 0; i < _vlist.size(); ++i)
+	for (int i = 0; i < _verts.size(); ++i)
 	{
-		_vlist[i].getXYZ() -= transv;
-		_vlist[i].getXYZ() *= Scale;
+		vertex v = getVertex(i);
+		v.getXYZ() -= transv;
+		v.getXYZ() *= Scale;
 	}
 }
 
@@ -20,8 +20,36 @@
 #include <vector>
 #include "vertex.h"
 #include "triangle.h"
+#include "adjacency.h"
+#include "cornertable.h"
 using namespace std;
 
+class MappedFile;
+
+// Layout of the vertex & face records in a PLY file, as described
+// by the file's header.  Used to decode binary PLY files in place.
+struct PlyLayout
+{
+	// Storage format of the body of the file
+	enum Format {ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN};
+
+	// Scalar types allowed in a PLY file
+	enum Type {NO_TYPE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64};
+
+	Format format;
+	size_t headerSize; // # of bytes up to & including "end_header"
+	size_t vertexStart; // byte offset (from end of header) of 1st vertex record
+
+	int vertexSize; // # of bytes in each vertex record
+	int xyzOffset[3]; // offset of x, y, z within a vertex record
+	Type xyzType[3]; // type of x, y, z
+
+	int facePrefixSize; // # of bytes of scalar properties before the index list
+	int faceSuffixSize; // # of bytes of scalar properties after the index list
+	Type faceCountType; // type of the count in "property list <count> <index> vertex_indices"
+	Type faceIndexType; // type of the indices in the list
+};
+
 
 // Mesh class.  This stores a list of vertices &
 // another list of triangles (which references the vertex list)
@@ -37,16 +65,59 @@ public:
 	Mesh& operator=(const Mesh&); // assignment op
 
 	// Get list of vertices, triangles
-	vertex& getVertex(int index) {return _vlist[index];};
-	const vertex& getVertex(int index) const {return _vlist[index];};
+	vertex getVertex(int index) {return vertex(&_verts, index);};
 	triangle& getTri(int index) {return _plist[index];};
 	const triangle& getTri(int index) const {return _plist[index];};
 
-	int getNumVerts() {return _numVerts;};
+	// The vertex data, one array per field (positions, normals, ...)
+	const VertexArrays& getVertexArrays() const {return _verts;}
+
+	// Make room for the vertices' quadrics, which aren't allocated
+	// unless a quadric edge collapse method uses them
+	void allocQuadrics() {_verts.allocQuadrics();}
+
+	// Neighbors of each vertex.  A vertex neighbor is connected by an
+	// edge; a triangle neighbor is a triangle which uses the vertex.
+	// The rows are sorted, in the same order as a set<int>.
+	AdjacencyRow getVertNeighbors(int v) const {return _vertNeighbors.row(v);}
+	AdjacencyRow getTriNeighbors(int v) const {return _triNeighbors.row(v);}
+
+	bool hasVertNeighbor(int v, int n) const {return _vertNeighbors.contains(v, n);}
+	bool hasTriNeighbor(int v, int t) const {return _triNeighbors.contains(v, t);}
+
+	void addVertNeighbor(int v, int n) {_vertNeighbors.insert(v, n);}
+	void addTriNeighbor(int v, int t) {_triNeighbors.insert(v, t);}
+
+	// remove a vertex which is no longer connected by an edge,
+	// or a triangle which no longer uses this vertex
+	unsigned removeVertNeighbor(int v, int n) {return _vertNeighbors.erase(v, n);}
+	unsigned removeTriNeighbor(int v, int t) {return _triNeighbors.erase(v, t);}
+
+	// Make room for this many neighbors, so they can be added while other
+	// threads change the neighbors of other vertices (see MutableAdjacency)
+	void reserveVertNeighbors(int v, int capacity) {_vertNeighbors.reserve(v, capacity);}
+	void reserveTriNeighbors(int v, int capacity) {_triNeighbors.reserve(v, capacity);}
+
+	// Go back to another copy's triangle neighbors (after a copy, they
+	// have the same triangles & vertices)
+	void copyTriNeighbors(const Mesh& m) {_triNeighbors = m._triNeighbors;}
+
+	// Corner table of the triangles, kept up to date through edge
+	// collapses & vertex splits (see CornerTable)
+	const CornerTable& getCorners() const {return _corners;}
+	CornerTable& getCorners() {return _corners;}
+
+	int getNumVerts() const {return _numVerts;};
 	void setNumVerts(int n) {_numVerts = n;};
-	int getNumTriangles() {return _numTriangles;};
+	int getNumTriangles() const {return _numTriangles;};
 	void setNumTriangles(int n) {_numTriangles = n;};
 
+	// Renumber the vertices & triangles:  vertex i becomes vertex
+	// newVert[i], & triangle i becomes triangle newTri[i].  The triangles
+	// are moved to this mesh (see changeMesh), & the neighbors, corners
+	// & vertex normals are built again.
+	void renumber(const vector<int>& newVert, const vector<int>& newTri);
+
 	void Normalize();// center mesh around the origin & shrink to fit in [-1, 1]
 
 	void calcOneVertNormal(unsigned vert); // recalc normal for one vertex
@@ -54,9 +125,16 @@ public:
 	void dump(); // print mesh state to cout
 
 private:
-	vector<vertex> _vlist; // list of vertices in mesh
+	VertexArrays _verts; // vertices in mesh, as a structure of arrays
 	vector<triangle> _plist; // list of triangles in mesh
 
+	MutableAdjacency _vertNeighbors; // vertices connected to each vertex via an edge
+	MutableAdjacency _triNeighbors; // triangles of which each vertex is a part
+
+	CornerTable _corners; // opposite corner of each corner of each triangle
+
+	enum {ADJACENCY_SLACK = 2}; // spare slots in each adjacency row, for edge collapses
+
 	int _numVerts;
 	int _numTriangles;
 
@@ -78,12 +156,33 @@ private:
 
 	void calcVertNormals(); // Calculate the vertex normals after loading the mesh
 
+	void pointTrisToThis(); // after copying another mesh, see changeMesh
+
 	// Helper function for reading PLY mesh file
 	bool readNumPlyVerts(FILE *&inFile, int& nVerts);
 	bool readNumPlyTris(FILE *&inFile, int& nTris);
 	bool readPlyHeader(FILE *&inFile);
 	bool readPlyVerts(FILE *&inFile);
 	bool readPlyTris(FILE *&inFile);
+
+	// update each vertex w/ its neighbors (vertices & triangles),
+	// & link the corners of the triangles, after all the triangles
+	// have been read
+	void buildAdjacency();
+
+	// Helper functions for reading binary PLY mesh files.  The file
+	// is memory mapped & the records are decoded directly into the
+	// vertex & triangle lists.
+	bool readPlyLayout(const MappedFile& file, PlyLayout& layout);
+	bool readBinaryPlyVerts(const char* body, size_t bodySize, const PlyLayout& layout);
+	bool readBinaryPlyTris(const char* body, size_t bodySize, const PlyLayout& layout);
+
+	// Helper function for reading ASCII PLY mesh files.  The body of
+	// the mapped file is split into line-aligned chunks which are
+	// parsed in parallel.  Returns false (without reporting an error)
+	// if the file can't be parsed this way, so the stdio readers can be
+	// used instead.
+	bool readAsciiPlyBody(const char* body, size_t bodySize);
 };
 
 #endif // __mesh_h
@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <float.h>
+#include <stdlib.h>
 
 #if defined (_MSC_VER) && (_MSC_VER >= 1020)
 #pragma warning(disable:4710) // function not inlined
@@ -10,9 +11,16 @@
 #pragma warning(disable:4786) /* disable "identifier was truncated to '255' characters in the browser information" warning in Visual C++ 6*/
 #endif
 
+#include <algorithm>
+#include <functional>
 #include <set>
 #include <map>
 #include <ostream>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "pmesh.h"
 
@@ -22,31 +30,39 @@
 
 // Constructor.  This will create the edge collapse list by
 // calling createEdgeCollapseList
-PMesh::PMesh(Mesh* mesh, EdgeCost ec)
+PMesh::PMesh(Mesh* mesh, EdgeCost ec, const CollapseLimits& limits, bool bParallel,
+			 Placement placement)
 {
 	assert(mesh);
 	assert(ec >= 0 && ec < MAX_EDGECOST);
+	assert(placement >= 0 && placement < MAX_PLACEMENT);
 
 	_mesh = mesh;
 	_cost = ec;
+	_limits = limits;
+	_bParallel = bParallel;
+	_placement = placement;
+	_checkpointInterval = 0;
+	_bViewRefined = false;
+	_nextRefineVert = 0;
 
 	createEdgeCollapseList();
 }
 
 // Used for debugging
-void dumpset(vertexPtrSet& ms)
+void dumpset(CostHeap& vh, Mesh& mesh)
 {
 	std::cout << "+++ Dumping set of vertices +++" << std::endl;
 
-	vertexPtrSet::iterator iter;
 	int i = 0;
-	for (iter = ms.begin(); iter != ms.end(); ++iter)
+	for (int v = 0; v < mesh.getNumVerts(); ++v)
 	{
+		if (!vh.contains(v)) continue;
+
 		std::cout << "\tvertex " << i++ << " in set: ";
-		const vertexPtr v = *iter;
-		std::cout << v._index;
-		const vertex& vtx = v._meshptr->getVertex(v._index);
-		std::cout << " cost: " << vtx.getCost();
+		std::cout << v;
+		const vertex vtx = mesh.getVertex(v);
+		std::cout << " cost: " << vh.getCost(v);
 		std::cout << " min edge vert: " << vtx.minCostEdgeVert();
 		std::cout << std::endl;
 	}
@@ -56,9 +72,7 @@ void dumpset(vertexPtrSet& ms)
 #ifdef PRINT_DEBUG_INFO
 
 // Used for debugging
-void checkConsistency(vertexPtrSet& ms,
-					  vector<vertexPtrSet::iterator>& vsv,
-					  Mesh& newmesh)
+void checkConsistency(CostHeap& vh, Mesh& newmesh)
 {
 	int i;
 	for (i = 0; i < newmesh.getNumTriangles(); ++i)
@@ -69,35 +83,23 @@ void checkConsistency(vertexPtrSet& ms,
 		int v1, v2, v3;
 		t.getVerts(v1, v2, v3);
 
-		const vertex& cv = newmesh.getVertex(v1);
-		assert(cv.hasTriNeighbor(t.getIndex()));
+		const vertex cv = newmesh.getVertex(v1);
+		assert(newmesh.hasTriNeighbor(v1, t.getIndex()));
 		assert(newmesh.getVertex(cv.getIndex()).isActive());
 
-		const vertex& cv2 = newmesh.getVertex(v2);
-		assert(cv2.hasTriNeighbor(t.getIndex()));
+		const vertex cv2 = newmesh.getVertex(v2);
+		assert(newmesh.hasTriNeighbor(v2, t.getIndex()));
 		assert(newmesh.getVertex(cv2.getIndex()).isActive());
 
-		const vertex& cv3 = newmesh.getVertex(v3);
-		assert(cv3.hasTriNeighbor(t.getIndex()));
+		const vertex cv3 = newmesh.getVertex(v3);
+		assert(newmesh.hasTriNeighbor(v3, t.getIndex()));
 		assert(newmesh.getVertex(cv3.getIndex()).isActive());
 	}
 
-	vertexPtrSet::iterator iter;
-
-	for (iter = ms.begin(); iter != ms.end(); ++iter)
-	{
-		// check vertex ptr points to active vertex
-		// const vertexPtr vp = *iter;
-		assert(newmesh.getVertex((*iter)._index).isActive());
-	}
-
+	// every vertex in the heap is active, & every active vertex is in the heap
 	for (i = 0; i < newmesh.getNumVerts(); ++i)
 	{
-		if (newmesh.getVertex(i).isActive())
-		{
-			assert(vsv[i]->_index == i);
-		}
-
+		assert(newmesh.getVertex(i).isActive() == vh.contains(i));
 	}
 }
 #endif //  PRINT_DEBUG_INFO
@@ -115,59 +117,85 @@ void PMesh::assertEveryVertActive(int nVerts, int nTri, Mesh &mesh)
 		assert(mesh.getTri(i).isActive());
 	}
 }
-#endif
 
-// Calculate the QEM matrices used to computer edge
-// collapse costs.
-void PMesh::calcQuadricMatrices(EdgeCost &cost, Mesh &mesh)
+// The normal stored in each active triangle should be the one
+// calcNormal() gets from the vertices where they are now
+void PMesh::assertTriNormalsMatch(const Mesh &mesh)
+{
+	const Vec3* positions = mesh.getVertexArrays().getPositions();
+	for (int i = 0; i < mesh.getNumTriangles(); ++i)
+	{
+		const triangle& t = mesh.getTri(i);
+		if (!t.isActive()) continue;
+		const Vec3& p1 = positions[t.getVert1Index()];
+		const Vec3& p2 = positions[t.getVert2Index()];
+		const Vec3& p3 = positions[t.getVert3Index()];
+		Vec3 d = (p2 - p1).unitcross(p3 - p2) - t.getNormalVec3();
+		assert(d.dot(d) < 1e-6f);
+	}
+}
+
+// The normal of each vertex which a visible triangle uses should be the
+// sum of the visible triangles' normals, normalized
+void PMesh::assertVertNormalsMatch(const Mesh &mesh)
 {
-	if (QUADRICTRI == cost)
+	const int nVerts = mesh.getNumVerts();
+	const Vec3* normals = mesh.getVertexArrays().getNormals();
+	vector<Vec3> sums(nVerts);
+	vector<bool> bVisible(nVerts, false);
+	int i;
+	for (i = 0; i < mesh.getNumTriangles(); ++i)
 	{
-		calcAllQMatrices(mesh, true);
+		const triangle& t = mesh.getTri(i);
+		if (!t.isActive()) continue;
+		for (int k = 0; k < 3; ++k)
+		{
+			sums[t.getVertIndex(k)] += t.getNormalVec3();
+			bVisible[t.getVertIndex(k)] = true;
+		}
 	}
-	else if (QUADRIC == cost)
+	for (i = 0; i < nVerts; ++i)
 	{
-		calcAllQMatrices(mesh, false);
-	};
+		if (!bVisible[i]) continue;
+		sums[i].normalize();
+		Vec3 d = sums[i] - normals[i];
+		assert(d.dot(d) < 1e-6f);
+	}
 }
+#endif
 
 // Calculate edge collapse costs.  Edges with low costs
 // are collapsed first.
-void PMesh::calcEdgeCollapseCosts(vertexPtrSet &vertSet, vector<vertexPtrSet::iterator> &vertSetVec, 
-								  int nVerts, Mesh &mesh, EdgeCost &cost)
+template <class Cost>
+void PMesh::calcEdgeCollapseCosts(CostHeap &vertHeap, int nVerts, Mesh &mesh)
 {
+	vertHeap.reset(nVerts);
+
+	// Each vertex's cost only depends on the mesh, so they're calculated
+	// in parallel.  They go in the heap in index order, so the order of 
+	// vertices w/ the same cost doesn't depend on the number of threads.
 	int i;
-	for (i = 0; i < nVerts; ++i)
+#pragma omp parallel
 	{
-		vertex& currVert = mesh.getVertex(i);
-		switch (cost)
-		{
-		case SHORTEST:
-			shortEdgeCollapseCost(mesh, currVert);
-			break;
-		case MELAX:
-			melaxCollapseCost(mesh, currVert);
-			break;
-		case QUADRIC: // deliberate fall through
-		case QUADRICTRI:
-			quadricCollapseCost(mesh, currVert);
-			break;
-		default:
-			break;
-		};
+		CollapseScratch scratch;
 
-		vertexPtr v;
-		v._index = i;
-		v._meshptr = &mesh;
+#pragma omp for schedule(dynamic, 1024)
+		for (i = 0; i < nVerts; ++i)
+		{
+			Cost::vertCost(*this, mesh, mesh.getVertex(i), scratch);
+		}
+	}
 
-		vertSetVec[i] = vertSet.insert(v); // inserts a copy
+	for (i = 0; i < nVerts; ++i)
+	{
+		vertHeap.push(i, mesh.getVertex(i).getCost());
 	}
 
 #ifdef PRINT_DEBUG_INFO
 	int count=0; // for debug
 	std::cout << "---- Initial State ----" << std::endl;
 	mesh.dump();
-	dumpset(vertSet);
+	dumpset(vertHeap, mesh);
 	std::cout << "---- End Initial State ----" << std::endl;
 #endif 
 }
@@ -175,8 +203,9 @@ void PMesh::calcEdgeCollapseCosts(vertexPtrSet &vertSet, vector<vertexPtrSet::it
 // We can't collapse Vertex1 to Vertex2 if Vertex2 is invalid.
 // This can happen if Vertex2 was previously collapsed to a
 // separate vertex.
-void PMesh::insureEdgeCollapseValid(EdgeCollapse &ec, vertex &vc, Mesh &mesh, 
-									const EdgeCost &cost, bool &bBadVertex)
+template <class Cost>
+void PMesh::insureEdgeCollapseValid(EdgeCollapse &ec, vertex vc, Mesh &mesh, 
+									bool &bBadVertex, CollapseScratch &scratch)
 {
 	int nLoopCount = 0;
 	for (;;) // at most this will loop twice -- the "to vertex" could have been removed, so it may need to be recalculated.
@@ -202,21 +231,7 @@ void PMesh::insureEdgeCollapseValid(EdgeCollapse &ec, vertex &vc, Mesh &mesh,
 		// If not vertex active, recalc
 		if (!mesh.getVertex(ec._vto).isActive())
 		{
-			switch (cost)
-			{
-			case SHORTEST:
-				shortEdgeCollapseCost(mesh, vc);
-				break;
-			case MELAX:
-				melaxCollapseCost(mesh, vc);
-				break;
-			case QUADRIC: // deliberate fall through!
-			case QUADRICTRI:
-				quadricCollapseCost(mesh, vc);
-				break;
-			default:
-				break;
-			};
+			Cost::vertCost(*this, mesh, vc, scratch);
 		}
 		else
 		{
@@ -229,39 +244,68 @@ void PMesh::insureEdgeCollapseValid(EdgeCollapse &ec, vertex &vc, Mesh &mesh,
 // Tom Forsyth (Mucky Foot, ex-Bullfrog) says these should
 // be averaged, not added(???) but we'll go with the 
 // original algorithm.
-void PMesh::setToVertexQuadric(vertex &to, vertex &from, const EdgeCost &cost)
+template <class Cost>
+void PMesh::setToVertexQuadric(vertex to, vertex from)
 {
-	if (QUADRIC == cost || QUADRICTRI == cost)
+	to.getQuadric() += from.getQuadric();
+	if (Cost::TRI_AREA)
 	{
-		int ct, ct2;
+		double combinedTriArea = to.getQuadricSummedTriArea() + from.getQuadricSummedTriArea();
+		to.setQuadricSummedTriArea(combinedTriArea);
+	}
+}
 
-		double Qf[4][4], Qt[4][4];
-		to.getQuadric(Qt);
-		from.getQuadric(Qf);
-		for (ct = 0; ct < 4; ++ct)
-		{
-			for (ct2 = 0; ct2 < 4; ++ct2)
-			{
-				Qt[ct][ct2] += Qf[ct][ct2];
-			}
-		}
-		to.setQuadric(Qt);
-		if (QUADRICTRI == cost)
-		{
-			double combinedTriArea = to.getQuadricSummedTriArea() + from.getQuadricSummedTriArea();
-			to.setQuadricSummedTriArea(combinedTriArea);
-		}
+// Find where the "to vertex" goes, & move it there.  This has to be
+// done while the "from vertex" & "to vertex" still have separate
+// quadrics, since the new position is found from their sum.
+template <class Cost>
+void PMesh::placeToVertex(EdgeCollapse &ec, Mesh &mesh)
+{
+	Vec3& toPos = mesh.getVertex(ec._vto).getXYZ();
+	ec._oldPosition = toPos;
+	ec._position = toPos;
+
+	if (PLACE_OPTIMAL != _placement) return;
+
+	int ev[2] = {ec._vfrom, ec._vto};
+	orientQuadricEdge<Cost>(mesh, ev, ec._position);
+	toPos = ec._position;
+}
+
+// If the "to vertex" moved, the triangles which already used it (i.e.
+// weren't changed by updateTriangles) have new normals.  They're saved
+// in the edge collapse, so their normals can be recalculated when the
+// mesh is simplified or restored.
+void PMesh::updateMovedTris(EdgeCollapse &ec, Mesh &mesh)
+{
+	if (ec._position == ec._oldPosition) return;
+
+	const AdjacencyRow triRow = mesh.getTriNeighbors(ec._vto);
+	for (const int* pt = triRow.begin(); pt != triRow.end(); ++pt)
+	{
+		triangle& t = mesh.getTri(*pt);
+		if (!t.isActive() || 
+			binary_search(ec._trisAffected.begin(), ec._trisAffected.end(), *pt)) continue;
+
+		t.calcNormal();
+		ec._trisMoved.push_back(*pt); // in order, since the row is sorted
 	}
 }
 
 // At this point, we have an edge collapse.  We're collapsing the "from vertex"
 // to the "to vertex."  For all the surrounding triangles which use this edge, 
 // update "from vertex" to the "to vertex".  Also keep track of the vertices
-// in the surrounding triangles. 
-void PMesh::updateTriangles(EdgeCollapse &ec, vertex &vc, set<int> &affectedVerts, Mesh &mesh)
+// in the surrounding triangles (sorted, w/o repeats).
+void PMesh::updateTriangles(EdgeCollapse &ec, vertex vc, vector<int> &affectedVerts, Mesh &mesh,
+							vector<int> &triNeighbors)
 {
-	set<int>& triNeighbors = vc.getTriNeighbors();
-	set<int>::iterator pos;
+	// Copy the triangle neighbors, since the loop below changes them.
+	// The row is sorted, so the triangles removed & affected are too.
+	const AdjacencyRow triRow = mesh.getTriNeighbors(vc.getIndex());
+	triNeighbors.assign(triRow.begin(), triRow.end());
+	vector<int>::const_iterator pos;
+
+	affectedVerts.clear();
 
 	for (pos = triNeighbors.begin(); pos != triNeighbors.end(); ++pos) 
 	{
@@ -272,7 +316,7 @@ void PMesh::updateTriangles(EdgeCollapse &ec, vertex &vc, set<int> &affectedVert
 		bool bRemoveTri = false;
 		if (t.hasVertex(ec._vfrom) && t.hasVertex(ec._vto))
 		{
-			ec._trisRemoved.insert(triIndex);
+			ec._trisRemoved.push_back(triIndex);
 			t.changeVertex(ec._vfrom, ec._vto); // update the vertex of this triangle
 
 			bRemoveTri = true;
@@ -285,52 +329,54 @@ void PMesh::updateTriangles(EdgeCollapse &ec, vertex &vc, set<int> &affectedVert
 			t.calcNormal(); // reset the normal for the triangle
 
 			// make sure the "to" vertex knows about this triangle
-			mesh.getVertex(ec._vto).addTriNeighbor(triIndex);
+			mesh.addTriNeighbor(ec._vto, triIndex);
 			
 			// If the triangle has an area effectively equal to 0, remove it.
 			// NOTE: should this be done?  The triangle could get bigger through 
 			// another edge collapse in another direction.
 			if (t.calcArea() < 1e-6) {
 				t.setActive(false);
-				ec._trisRemoved.insert(triIndex);
+				ec._trisRemoved.push_back(triIndex);
 				bRemoveTri = true;
 			} else {
-				ec._trisAffected.insert(triIndex);
+				ec._trisAffected.push_back(triIndex);
 			}
 
 		}
-		// update set of affected verts
-		// note that if you insert the same element twice, 
-		// it will only be stored once.
+		// update list of affected verts (the repeats are removed below)
 		int vert1, vert2, vert3;
 		t.getVerts(vert1, vert2, vert3);
 
-		affectedVerts.insert(vert1);
-		affectedVerts.insert(vert2);
-		affectedVerts.insert(vert3);
+		affectedVerts.push_back(vert1);
+		affectedVerts.push_back(vert2);
+		affectedVerts.push_back(vert3);
 
 		// If triangle is being removed, update each vertex which references it.
 		if (bRemoveTri)
 		{
-			mesh.getVertex(vert1).removeTriNeighbor(triIndex);
-			mesh.getVertex(vert2).removeTriNeighbor(triIndex);
-			mesh.getVertex(vert3).removeTriNeighbor(triIndex);
+			mesh.removeTriNeighbor(vert1, triIndex);
+			mesh.removeTriNeighbor(vert2, triIndex);
+			mesh.removeTriNeighbor(vert3, triIndex);
 		}
 	}
+
+	sort(affectedVerts.begin(), affectedVerts.end());
+	affectedVerts.erase(unique(affectedVerts.begin(), affectedVerts.end()), affectedVerts.end());
 }
 
 // These vertices are not in the current collapse, but are in the triangles
 // which share the collapsed edge.
-void PMesh::updateAffectedVertNeighbors(vertex &vert, const EdgeCollapse &ec, 
-										const set<int> &affectedVerts)
+void PMesh::updateAffectedVertNeighbors(vertex vert, const EdgeCollapse &ec, 
+										const vector<int> &affectedVerts, Mesh &mesh)
 {
-	if (vert.getIndex() != ec._vto)
+	const int vi = vert.getIndex();
+	if (vi != ec._vto)
 	{
-		vert.addVertNeighbor(ec._vto); // make sure vertex knows it has a new neighbor
+		mesh.addVertNeighbor(vi, ec._vto); // make sure vertex knows it has a new neighbor
 	}
 	else
 	{
-		set<int>::const_iterator mappos2;
+		vector<int>::const_iterator mappos2;
 
 		// Make sure the "to" vertex knows about its
 		// new neighbors
@@ -338,77 +384,40 @@ void PMesh::updateAffectedVertNeighbors(vertex &vert, const EdgeCollapse &ec,
 		{
 			if (*mappos2 != ec._vto)
 			{
-				vert.addVertNeighbor(*mappos2); 
+				mesh.addVertNeighbor(vi, *mappos2); 
 			}
 		}
 	}
 
 	// get rid of deleted vertex
-	vert.removeVertNeighbor(ec._vfrom);
-}
-
-// Reset the edge collapse costs of vertices which were
-// affected by a previous edge collapse.
-void PMesh::resetAffectedVertCosts(const EdgeCost &cost, Mesh &mesh, vertex &vert)
-{
-	switch (cost)
-	{
-	case SHORTEST:
-		shortEdgeCollapseCost(mesh, vert);
-		break;
-	case MELAX:
-		melaxCollapseCost(mesh, vert);
-		break;
-	case QUADRIC: // deliberate fall through!
-	case QUADRICTRI:
-		// Don't calculate the quadric Collapse cost yet, because we
-		// can't do that until the Q matrix is calculated for each vertes
-		// that is a neighbor of this vertex.  
-		// We will calculate the quadric collapse cost later for all affected
-		// vertices which are still active.
-		break;
-	default:
-		break;
-	};
+	mesh.removeVertNeighbor(vi, ec._vfrom);
 }
 
 
-// If this vertex has no active triangles (i.e. triangles which have
-// not been removed from the mesh) then set it to inactive.
-void PMesh::removeVertIfNecessary(vertex &vert, vertexPtrSet &vertSet, 
-								  vector<vertexPtrSet::iterator> &vertSetVec, 
-								  Mesh &mesh, const EdgeCost &cost, 
-									set<int> &affectedQuadricVerts)
-{
-	bool bActiveVert = false;
-	set<int>& mytriNeighbors = vert.getTriNeighbors();
-	set<int>::iterator pos2;
+// Is this vertex used by any active triangle?
+static bool hasActiveTri(vertex vert, Mesh &mesh)
+{
+	const AdjacencyRow mytriNeighbors = mesh.getTriNeighbors(vert.getIndex());
+	const int* pos2;
 	for (pos2 = mytriNeighbors.begin(); pos2 != mytriNeighbors.end(); ++pos2) 
 	{
 		// get triangle
 		int triIndex = *pos2;
 		triangle& t = mesh.getTri(triIndex);
 		if (t.isActive()) {
-			bActiveVert = true;
-			break;
+			return true;
 		}
 	}
+	return false;
+}
 
-	if (bActiveVert) { // if vert is active
-		vertexPtr vp;
-		vp._index = vert.getIndex();
-		vp._meshptr = &mesh;
-		vertSetVec[vp._index] = vertSet.insert(vp);
-
-		assert(vertSetVec[vp._index]->_index == vp._index);
-		mesh.getVertex(vp._index).setActive(true); 
-
-		// If we're calculating quadric costs, keep track of
-		// every active vertex which was affect by this collapse,
-		// so we can recalculate collapse costs.
-		if (QUADRIC == cost || QUADRICTRI == cost) {
-			affectedQuadricVerts.insert(vert.getIndex());
-		}
+// If this vertex has no active triangles (i.e. triangles which have
+// not been removed from the mesh) then set it to inactive.
+void PMesh::removeVertIfNecessary(vertex vert, CostHeap &vertHeap, Mesh &mesh)
+{
+	if (hasActiveTri(vert, mesh)) { // if vert is active
+		vertHeap.update(vert.getIndex(), vert.getCost());
+		vert.setActive(true); 
 #ifdef PRINT_DEBUG_INFO
 		std::cout << "\tvert affected: " << vert.getIndex() << std::endl;
 #endif
@@ -417,52 +426,62 @@ void PMesh::removeVertIfNecessary(vertex &vert, vertexPtrSet &vertSet,
 #ifdef PRINT_DEBUG_INFO
 		std::cout << "\tvert removed: " << vert.getIndex() << std::endl;
 #endif
-		mesh.getVertex(vert.getIndex()).setActive(false);
+		vertHeap.erase(vert.getIndex());
+		vert.setActive(false);
 	}
 }
 
 // Update the vertices affected by the most recent edge collapse
-void PMesh::updateAffectedVerts(Mesh &mesh, vector<vertexPtrSet::iterator> &vertSetVec, 
-								vertexPtrSet &vertSet, const EdgeCollapse &ec, 
-								set<int> &affectedVerts, const EdgeCost &cost, 
-								set<int> &affectedQuadricVerts)
+template <class Cost>
+void PMesh::updateAffectedVerts(Mesh &mesh, CostHeap &vertHeap, 
+								const EdgeCollapse &ec, 
+								CollapseScratch &scratch)
 {
-	set<int>::iterator mappos;
+	const vector<int> &affectedVerts = scratch._affectedVerts;
+	vector<int>::const_iterator mappos;
 	for (mappos = affectedVerts.begin(); mappos != affectedVerts.end(); ++mappos)
 	{
 
-		vertex& vert = mesh.getVertex(*mappos);
+		vertex vert = mesh.getVertex(*mappos);
 		assert(vert.getIndex() == *mappos);
 
-		// Always erase, maybe add in.
-		// Can't change in place, 'cause will screw up order of set
-		vertSet.erase(vertSetVec[*mappos]);
-		vertSetVec[*mappos] = vertSet.end(); // set to "invalid" value
-
-		updateAffectedVertNeighbors(vert, ec, affectedVerts);
+		updateAffectedVertNeighbors(vert, ec, affectedVerts, mesh);
 
 		// reset values for affected vertices
-		resetAffectedVertCosts(cost, mesh, vert);
+		Cost::vertCost(*this, mesh, vert, scratch);
 
-		// Remove vertex if it's not attached to any active triangle
-		removeVertIfNecessary(vert, vertSet, vertSetVec, mesh,
-								cost, affectedQuadricVerts);
+		// Remove vertex if it's not attached to any active triangle,
+		// otherwise update its place in the heap
+		removeVertIfNecessary(vert, vertHeap, mesh);
 	}
 }
 
-// Recalculate the QEM matrices (yeah, that's redundant) if we're
-// using the Quadrics to calculate edge collapse costs.
-void PMesh::recalcQuadricCollapseCosts(set<int> &affectedQuadricVerts, 
-									   Mesh &mesh, const EdgeCost &cost)
+// After an edge collapse, link the corners of the triangles again.
+// Every edge which changed uses the "to vertex", except the far edge
+// of a triangle which was removed because it had no area (one which
+// still has 3 different vertices).
+void PMesh::relinkCorners(const EdgeCollapse &ec, Mesh &mesh)
+{
+	mesh.getCorners().relinkVert(mesh, ec._vto);
+	relinkRemovedTriCorners(ec, mesh);
+}
+
+// Link the corners around the vertices of the triangles w/ no area which
+// were removed by an edge collapse
+void PMesh::relinkRemovedTriCorners(const EdgeCollapse &ec, Mesh &mesh)
 {
-	if (QUADRIC == cost || QUADRICTRI == cost)
+	CornerTable& corners = mesh.getCorners();
+
+	vector<int>::const_iterator pos;
+	for (pos = ec._trisRemoved.begin(); pos != ec._trisRemoved.end(); ++pos)
 	{
-		set<int>::iterator mappos;
-		for (mappos = affectedQuadricVerts.begin(); mappos != affectedQuadricVerts.end(); ++mappos)
-		{			
-			vertex& vert = mesh.getVertex(*mappos);
-			quadricCollapseCost(mesh, vert);
-		}
+		int v1, v2, v3;
+		mesh.getTri(*pos).getVerts(v1, v2, v3);
+		if (v1 == v2 || v2 == v3 || v1 == v3) continue;
+
+		if (v1 != ec._vto) corners.relinkVert(mesh, v1);
+		if (v2 != ec._vto) corners.relinkVert(mesh, v2);
+		if (v3 != ec._vto) corners.relinkVert(mesh, v3);
 	}
 }
 
@@ -470,14 +489,18 @@ void PMesh::recalcQuadricCollapseCosts(set<int> &affectedQuadricVerts,
 // consists of two vertices:  a "from vertex" and a "to vertex".
 // The "from vertex" is collapsed to the "to vertex".  The
 // "from vertex" is removed from the mesh.
-void PMesh::buildEdgeCollapseList(Mesh &mesh, const EdgeCost &cost, 
-								  list<EdgeCollapse> &edgeCollList,
-									vertexPtrSet &vertSet, 
-									vector<vertexPtrSet::iterator> &vertSetVec)
+template <class Cost>
+void PMesh::buildEdgeCollapseList(Mesh &mesh, 
+								  CollapseHistory &history,
+									CostHeap &vertHeap, int nVisTris)
 {
+	CollapseScratch scratch;
+	EdgeCollapse ec; // reused for each collapse, so its vectors keep their memory
+	int nCollapses = 0;
 	for (;;)
 	{
-		if (0 == vertSet.size())
+		if (vertHeap.empty() || 
+			limitReached(vertHeap.topCost(), nCollapses, nVisTris))
 		{
 			// we're done
 			break;
@@ -485,22 +508,20 @@ void PMesh::buildEdgeCollapseList(Mesh &mesh, const EdgeCost &cost,
 
 #ifdef PRINT_DEBUG_INFO
 		// check consistency in data structures
-		checkConsistency(vertSet, vertSetVec, mesh);
+		checkConsistency(vertHeap, mesh);
 #endif
 
-		const vertexPtr vp = *(vertSet.begin()); // This is a copy of the first element
-		vertex vc = mesh.getVertex(vp._index);
-		assert(vp._index == vc.getIndex());
+		vertex vc = mesh.getVertex(vertHeap.top()); // vertex with the lowest cost
 
-		EdgeCollapse ec; // create EdgeCollapse structure
+		ec.clear();
 
 		bool bBadVertex = false;
 
 		// Make sure this edge collapse has a valid "to vertex"
-		insureEdgeCollapseValid(ec, vc, mesh, cost, bBadVertex);
+		insureEdgeCollapseValid<Cost>(ec, vc, mesh, bBadVertex, scratch);
 
 		mesh.getVertex(ec._vfrom).setActive(false);
-		vertSet.erase(vertSet.begin());
+		vertHeap.erase(vc.getIndex());
 
 		if (bBadVertex) {
 			continue;
@@ -510,586 +531,1981 @@ void PMesh::buildEdgeCollapseList(Mesh &mesh, const EdgeCost &cost,
 		std::cout << "from: " << ec._vfrom << " to: " << ec._vto << std::endl;
 #endif
 
-		vertex& to = mesh.getVertex(ec._vto);
-		vertex& from = mesh.getVertex(ec._vfrom);
-
-		setToVertexQuadric(to, from, cost);
-
-		set<int> affectedVerts;
-
 		// We are removing a vertex and an edge.  Look at all triangles
 		// which use this vertex.  Each of these triangles is either being
 		// removed or updated with a new vertex.
-		updateTriangles(ec, vc, affectedVerts, mesh);
-		
-		set<int> affectedQuadricVerts;
+		updateTriangles(ec, vc, scratch._affectedVerts, mesh, scratch._triNeighbors);
+
+		// Link the corners on the edges which changed
+		relinkCorners(ec, mesh);
 
 		// These vertices were in triangles which either were removed or
 		// were updated with new vertices.  Removed these vertices if they're
 		// not connected to an active triangle.  Update these vertices if they're
 		// still being displayed.
-		updateAffectedVerts(mesh, vertSetVec, vertSet, ec, affectedVerts,
-							cost, affectedQuadricVerts);
-
-		// If using the quadric collapse method, 
-		// recalculate the edge collapse costs for the affected vertices.
-		recalcQuadricCollapseCosts(affectedQuadricVerts, mesh, cost);
+		updateAffectedVerts<Cost>(mesh, vertHeap, ec, scratch);
 
 #ifdef PRINT_DEBUG_INFO
 		std::cout << "---- Collapse # "<< count++ << " ----" << std::endl;
 		mesh.dump();
 		ec.dumpEdgeCollapse();
-		dumpset(vertSet);
+		dumpset(vertHeap, mesh);
 #endif
 
-		edgeCollList.push_back(ec); // inserts a copy
+		history.append(ec);
+		++nCollapses;
+		nVisTris -= ec._trisRemoved.size();
 	}
 }
 
-// Where most of the work of the program is done.
-// This will create a list of edge collapses.  Each edge collapse
-// is a set of 2 vertices, a from vertex & a to vertex.  The from
-// vertex will be collapsed to the to vertex.  No new vertices are created,
-// only vertices in the original mesh are used.
-void PMesh::createEdgeCollapseList()
+// Find the edges of the mesh (each pair of vertex neighbors), & the
+// cost of collapsing each one.
+template <class Cost>
+void PMesh::buildQuadricEdges(Mesh &mesh, QuadricEdges &edges)
 {
-	// okay, get list of verts, tris
-	// for each vert, calc cost
-	// add to edge collapse list
-
-	// Copy the original mesh
-	_newmesh = *_mesh;
-
-	_edgeCollList.clear(); // empty list
-
-	int nVerts = _newmesh.getNumVerts();
-	int nTri = _newmesh.getNumTriangles();
-
-	_nVisTriangles = nTri; // number of visible triangles
-	
-	// assert each vert is active -- sanity check
-
-#ifndef NDEBUG
-	assertEveryVertActive(nVerts, nTri, _newmesh);
-#endif
-
-	// calculate all 4x4 Q matrices for each vertex 
-	// if using the Quadric method
-	calcQuadricMatrices(_cost, _newmesh);
-
-	// This is a set of vertex pointers, ordered by edge collapse cost.
-	vertexPtrSet vertSet;
-	vector<vertexPtrSet::iterator> vertSetVec(nVerts);
-
-	// Go through, calc cost here for all vertices
-	calcEdgeCollapseCosts(vertSet, vertSetVec, nVerts, _newmesh, _cost);
+	const int nVerts = mesh.getNumVerts();
+	int v;
 
-	// For all vertices:
-	//	find lowest cost
-	//	store the edge collapse structure
-	//	update all verts, triangles affected by the edge collapse
-	buildEdgeCollapseList(_newmesh, _cost, _edgeCollList,
-							vertSet, vertSetVec);
+	edges._verts.clear();
+	for (v = 0; v < nVerts; ++v)
+	{
+		const AdjacencyRow neighbors = mesh.getVertNeighbors(v);
+		for (const int* pos = neighbors.begin(); pos != neighbors.end(); ++pos)
+		{
+			if (*pos <= v) continue; // each edge once, & not the vertex itself
+			edges._verts.push_back(v);
+			edges._verts.push_back(*pos);
+		}
+	}
+	const int nEdges = (int) edges._verts.size() / 2;
+
+	CSRAdjacency vertEdges;
+	vertEdges.buildVertEdges(nEdges ? &edges._verts[0] : 0, nEdges, nVerts);
+	edges._vertEdges.assign(vertEdges, EDGE_SLACK);
+
+	// Edge costs are calculated in parallel, then go in the heap in
+	// edge order.
+	vector<double> costs(nEdges);
+	int e;
+#pragma omp parallel for
+	for (e = 0; e < nEdges; ++e)
+	{
+		costs[e] = orientQuadricEdge<Cost>(mesh, &edges._verts[2 * e]);
+	}
 
-	_newmesh = *_mesh;
-	for (int i = 0; i < nTri; ++i)
+	edges._heap.reset(nEdges);
+	for (e = 0; e < nEdges; ++e)
 	{
-		_newmesh.getTri(i).setActive(true);
+		edges._heap.push(e, costs[e]);
 	}
+}
 
-	// set iterator to point to beginning
-	_edgeCollapseIter = _edgeCollList.begin();
+// Remove an edge from the heap & from the rows of both its vertices
+static void removeQuadricEdge(QuadricEdges &edges, int e)
+{
+	edges._heap.erase(e);
+	edges._vertEdges.erase(edges._verts[2 * e], e);
+	edges._vertEdges.erase(edges._verts[2 * e + 1], e);
 }
 
+// Set the cost of an edge in the heap.  Don't move the edge behind other
+// edges w/ the same cost, if its cost didn't change.
+static void setQuadricEdgeCost(QuadricEdges &edges, int e, double cost)
+{
+	if (!edges._heap.contains(e) || edges._heap.getCost(e) != cost)
+	{
+		edges._heap.update(e, cost);
+	}
+}
 
-// Calculate the 4x4 Q Matrix used for the Quadric calculation
-// for each vertex
-void PMesh::calcAllQMatrices(Mesh& mesh, bool bUseTriArea)
+// After an edge collapse, update the edges around the "to vertex".
+template <class Cost>
+void PMesh::updateQuadricEdges(const EdgeCollapse &ec, CollapseScratch &scratch, 
+							   Mesh &mesh, QuadricEdges &edges)
 {
-	set<border> borderSet;
+	vector<int> &removedEdges = scratch._removedEdges;
+	removedEdges.clear();
+	moveQuadricEdges(ec, scratch._affectedVerts, mesh, edges, removedEdges);
 
-	int nVerts = mesh.getNumVerts();
+	vector<int>::const_iterator pos;
+	for (pos = removedEdges.begin(); pos != removedEdges.end(); ++pos)
+	{
+		removeQuadricEdge(edges, *pos);
+	}
 
-	for (int i = 0; i < nVerts; ++i)
+	// The "to vertex" has a new quadric, so its edges have new costs
+	const AdjacencyRow toRow = edges._vertEdges.row(ec._vto);
+	for (const int* pe = toRow.begin(); pe != toRow.end(); ++pe)
 	{
-		vertex& currVert = mesh.getVertex(i);
+		calcQuadricEdgeCost<Cost>(mesh, edges, *pe);
+	}
+}
 
-		currVert.calcQuadric(mesh, bUseTriArea);
+// Move the edges of the "from vertex" to the "to vertex".  The edges which
+// are no longer needed are added to removedEdges, but are left in the heap
+// & in the rows of their other vertices.  (An edge may be added twice.)
+void PMesh::moveQuadricEdges(const EdgeCollapse &ec, const vector<int> &affectedVerts, 
+							 Mesh &mesh, QuadricEdges &edges, vector<int> &removedEdges)
+{
+	// The "from vertex"'s edges now belong to the "to vertex".  Drop the
+	// collapsed edge, & any edge the "to vertex" already has.  (The vertex
+	// neighbors haven't been updated yet, so they tell us which edges the
+	// "to vertex" has.)  The row is walked backwards, since each edge 
+	// which is moved is erased from it.
+	int k;
+	for (k = edges._vertEdges.row(ec._vfrom).size() - 1; k >= 0; --k)
+	{
+		const int e = edges._vertEdges.row(ec._vfrom).begin()[k];
+		int* ev = &edges._verts[2 * e];
+		const int other = (ev[0] == ec._vfrom) ? ev[1] : ev[0];
 
-		double myQ[4][4];
-		currVert.getQuadric(myQ);
-		double triArea = 0;
-		
-		if (QUADRICTRI == _cost)
+		if (other == ec._vto || !binary_search(affectedVerts.begin(), affectedVerts.end(), other) || 
+			mesh.hasVertNeighbor(ec._vto, other))
 		{
-			triArea = currVert.getQuadricSummedTriArea();
+			removedEdges.push_back(e);
+			continue;
 		}
 
-		calcQuadricError(myQ, currVert, triArea);
-
-		// Is the current vertex on a border?  If so, get the
-		// edge information
-		currVert.getAllBorderEdges(borderSet, mesh);
+		edges._vertEdges.erase(ec._vfrom, e);
+		if (ev[0] == ec._vfrom) ev[0] = ec._vto;
+		else ev[1] = ec._vto;
+		edges._vertEdges.insert(ec._vto, e);
 	}
 
-	// Keep the mesh borders from being "eaten away".
-	if (!borderSet.empty())
+	vector<int>::const_iterator mappos;
+	for (mappos = affectedVerts.begin(); mappos != affectedVerts.end(); ++mappos)
 	{
-		applyBorderPenalties(borderSet, mesh);
+		vertex vert = mesh.getVertex(*mappos);
+		updateAffectedVertNeighbors(vert, ec, affectedVerts, mesh);
+
+		// Remove vertex (& its edges) if it's not attached to any active triangle
+		if (!hasActiveTri(vert, mesh))
+		{
+			vert.setActive(false);
+			const AdjacencyRow vertRow = edges._vertEdges.row(*mappos);
+			removedEdges.insert(removedEdges.end(), vertRow.begin(), vertRow.end());
+		}
 	}
 }
 
-// Border penalties are used to prevent mesh edges from collapsing
-// too soon.  This causes holes & T-junctions in the mesh to expand,
-// and causes the edges of the mesh to be "eaten away".  2-manifold,
-// closed meshes will not need to worry about this, and won't have
-// any border penalties.
-void PMesh::applyBorderPenalties(set<border> &borderSet, Mesh &mesh)
+// Calculate the list of edge collapses for the quadric methods.  Each
+// step collapses the edge w/ the lowest cost.
+template <class Cost>
+void PMesh::buildQuadricEdgeCollapseList(Mesh &mesh, CollapseHistory &history,
+										 QuadricEdges &edges, int nVisTris)
 {
-	set<border>::iterator pos;
-
-	for (pos = borderSet.begin(); pos != borderSet.end(); ++pos) 
+	CollapseScratch scratch;
+	EdgeCollapse ec; // reused for each collapse, so its vectors keep their memory
+	int nCollapses = 0;
+	while (!edges._heap.empty())
 	{
-		// First, determine the plane equation of plane perpendicular 
-		// to the edge triangle.
+		if (limitReached(edges._heap.topCost(), nCollapses, nVisTris)) break;
 
-		border edgeInfo = *pos;
+		const int e = edges._heap.top();
 
-		vertex& v1 = mesh.getVertex(edgeInfo.vert1);
-		vertex& v2 = mesh.getVertex(edgeInfo.vert2);
+		ec.clear();
+		ec._vfrom = edges._verts[2 * e];
+		ec._vto = edges._verts[2 * e + 1];
 
-		Vec3 &vec1 = v1.getXYZ();
-		Vec3 &vec2 = v2.getXYZ();
+#ifdef PRINT_DEBUG_INFO
+		std::cout << "from: " << ec._vfrom << " to: " << ec._vto << std::endl;
+#endif
 
-		Vec3 edge = vec1 - vec2;
+		vertex to = mesh.getVertex(ec._vto);
+		vertex from = mesh.getVertex(ec._vfrom);
+		assert(to.isActive() && from.isActive());
 
-		triangle &tri = mesh.getTri(edgeInfo.triIndex);
-		Vec3 normal = tri.getNormalVec3();
+		from.setActive(false);
+		placeToVertex<Cost>(ec, mesh);
+		setToVertexQuadric<Cost>(to, from);
 
-		Vec3 abc = edge.unitcross(normal);
-		float &a = abc.x;
-		float &b = abc.y;
-		float &c = abc.z;
+		// We are removing a vertex and an edge.  Look at all triangles
+		// which use this vertex.  Each of these triangles is either being
+		// removed or updated with a new vertex.
+		updateTriangles(ec, from, scratch._affectedVerts, mesh, scratch._triNeighbors);
+		updateMovedTris(ec, mesh);
 
-		float d = -(abc.dot(vec1));
+		// Link the corners on the edges which changed
+		relinkCorners(ec, mesh);
 
+		// Move the edges to the "to vertex" & recalculate their costs.
+		// This removes the collapsed edge from the heap.
+		updateQuadricEdges<Cost>(ec, scratch, mesh, edges);
 
-		double QuadricConstraint[4][4];
-		// NOTE: we could optimize this a bit by calculating values
-		// like a * b and then using that twice (for Quadric[0][1] and Quadric[1][0]),
-		// etc., since the matrix is symmetrical.  For now, I don't think
-		// it's worth it.
-		QuadricConstraint[0][0] = BOUNDARY_WEIGHT * a * a;
-		QuadricConstraint[0][1] = BOUNDARY_WEIGHT * a * b;
-		QuadricConstraint[0][2] = BOUNDARY_WEIGHT * a * c;
-		QuadricConstraint[0][3] = BOUNDARY_WEIGHT * a * d;
+		history.append(ec);
+		++nCollapses;
+		nVisTris -= ec._trisRemoved.size();
+	}
+}
 
-		QuadricConstraint[1][0] = BOUNDARY_WEIGHT * b * a;
-		QuadricConstraint[1][1] = BOUNDARY_WEIGHT * b * b;
-		QuadricConstraint[1][2] = BOUNDARY_WEIGHT * b * c;
-		QuadricConstraint[1][3] = BOUNDARY_WEIGHT * b * d;
+bool PMesh::limitReached(double cost, int nCollapses, int nVisTris) const
+{
+	return ((_limits._minTris > 0 && nVisTris <= _limits._minTris) || 
+			cost > _limits._maxCost || 
+			nCollapses >= _limits._maxCollapses);
+}
 
-		QuadricConstraint[2][0] = BOUNDARY_WEIGHT * c * a;
-		QuadricConstraint[2][1] = BOUNDARY_WEIGHT * c * b;
-		QuadricConstraint[2][2] = BOUNDARY_WEIGHT * c * c;
-		QuadricConstraint[2][3] = BOUNDARY_WEIGHT * c * d;
+// Start the next round of the parallel build:  empty the batch, & find
+// how many candidates to take from the heap.
+void PMesh::startBatch(CollapseBatch &batch, int heapSize, int &maxCandidates)
+{
+	++batch._nRound;
+	batch._candidates.clear();
+	batch._candidateCosts.clear();
+	batch._collapses.clear();
+	batch._costs.clear();
+
+	maxCandidates = heapSize / CANDIDATE_FRACTION;
+	if (maxCandidates < MIN_CANDIDATES) maxCandidates = MIN_CANDIDATES;
+}
 
-		QuadricConstraint[3][0] = BOUNDARY_WEIGHT * d * a;
-		QuadricConstraint[3][1] = BOUNDARY_WEIGHT * d * b;
-		QuadricConstraint[3][2] = BOUNDARY_WEIGHT * d * c;
-		QuadricConstraint[3][3] = BOUNDARY_WEIGHT * d * d;
+// Find the vertices of the triangles around the "from" & "to" vertices
+// of an edge collapse (w/ repeats), & the # of triangles w/ both.  These
+// are the vertices whose rows, triangles & corners the collapse changes.
+static void findCollapseVerts(const EdgeCollapse &ec, Mesh &mesh, 
+							  vector<int> &verts, int &nTrisRemoved)
+{
+	verts.clear();
+	verts.push_back(ec._vfrom);
+	verts.push_back(ec._vto);
+	nTrisRemoved = 0;
 
-		// Now add the constraint quadric to the quadrics for both of the 
-		// vertices.
-		double Q1[4][4], Q2[4][4];
-		v1.getQuadric(Q1);
-		v2.getQuadric(Q2);
-		for (int ct = 0; ct < 4; ++ct)
+	const int ends[2] = {ec._vfrom, ec._vto};
+	for (int k = 0; k < 2; ++k)
+	{
+		const AdjacencyRow tris = mesh.getTriNeighbors(ends[k]);
+		for (const int* pt = tris.begin(); pt != tris.end(); ++pt)
 		{
-			for (int ct2 = 0; ct2 < 4; ++ct2)
-			{
-				Q1[ct][ct2] += QuadricConstraint[ct][ct2];
-				Q2[ct][ct2] += QuadricConstraint[ct][ct2];
-			}
+			const triangle& t = mesh.getTri(*pt);
+			if (!t.isActive()) continue;
+
+			verts.push_back(t.getVertIndex(0));
+			verts.push_back(t.getVertIndex(1));
+			verts.push_back(t.getVertIndex(2));
+
+			if (0 == k && t.hasVertex(ec._vto)) ++nTrisRemoved;
 		}
-		v1.setQuadric(Q1);
-		v2.setQuadric(Q2);
 	}
 }
 
-
-// Calculate the cost of collapsing this vertex using the
-// "shortest edge" method.
-double PMesh::shortEdgeCollapseCost(Mesh& m, vertex& v)
+// Pick the batch from the candidates, cheapest first.  A candidate goes
+// in the batch if none of its vertices are used by a collapse already in
+// it.  The others are added to deferred (by their # in the candidates),
+// for a later round.  Returns false if a limit was reached.
+bool PMesh::pickBatch(Mesh &mesh, CollapseBatch &batch, QuadricEdges *edges,
+					  int nCollapses, int nVisTris, vector<int> &deferred)
 {
-	// get list of all active neighbors
-	// calculate shortest edge
-	// what if no neighbors??
-	// return cost
-	float mincost = FLT_MAX; // from float.h
-	bool bNeighborFound = false;
-
-	set<int>& neighbors = v.getVertNeighbors();
-	set<int>::iterator pos;
-	for (pos = neighbors.begin(); pos != neighbors.end(); ++pos) 
+	deferred.clear();
+	for (int i = 0; i < (int) batch._candidates.size(); ++i)
 	{
-		vertex& n = m.getVertex(*pos);
-		if (!n.isActive()) continue;
-		if (n == v) continue;
+		const EdgeCollapse &ec = batch._candidateCollapses[i];
+		if (batch._bBadCandidate[i])
+		{
+			mesh.getVertex(ec._vfrom).setActive(false);
+			continue;
+		}
 
-		// calc cost
-		Vec3 s = v.getXYZ() - n.getXYZ();
-		float cost = s.length();
+		if (limitReached(batch._candidateCosts[i], nCollapses + (int) batch._collapses.size(), nVisTris))
+		{
+			return false;
+		}
 
-		if (cost < mincost)
+		if (!claimCollapse(ec, batch._candidateVerts[i], mesh, batch, edges))
 		{
-			bNeighborFound = true;
-			mincost = cost;
-			v.setEdgeRemoveCost(cost);
-			v.setMinCostEdgeVert(*pos);
-			assert(v.minCostEdgeVert() >= 0 && v.minCostEdgeVert() < m.getNumVerts());
+			deferred.push_back(i);
+			continue;
 		}
+
+		assert(mesh.getVertex(ec._vto).isActive() && mesh.getVertex(ec._vfrom).isActive());
+		mesh.getVertex(ec._vfrom).setActive(false);
+
+		batch._collapses.push_back(ec);
+		batch._costs.push_back(batch._candidateCosts[i]);
+		nVisTris -= batch._nCandidateTrisRemoved[i]; // (not counting triangles w/ no area)
 	}
-	
-	if (bNeighborFound) {
-		return mincost;
-	} else {
-		return FLT_MAX; // vertex not connected to an edge
-	}
+	return true;
 }
 
-
-// Helper function for melaxCollapseCost().  This function
-// will loop through all the triangles to which this vertex
-// belongs.
-void PMesh::calcMelaxMaxValue(Mesh &mesh, set<int> &adjfaces, 
-							  vertex &v, set<int> &tneighbors,
-								float &retmaxValue, 
-								bool &bMaxValueFound)
+// Can this edge collapse go in the batch?  It can if none of its vertices
+// (see findCollapseVerts) are used by another collapse in the batch.  If
+// so, they're marked as used, & the rows which the collapse adds to get
+// room for the new entries, so no row is moved while the batch is done
+// in parallel.
+bool PMesh::claimCollapse(const EdgeCollapse &ec, const vector<int> &verts, Mesh &mesh,
+						  CollapseBatch &batch, QuadricEdges *edges)
 {
-	bool bMinValueFound  = false;
-	if (adjfaces.size() > 1 && v.isBorder(mesh))
+	vector<int>::const_iterator pos;
+	for (pos = verts.begin(); pos != verts.end(); ++pos)
 	{
-		retmaxValue = 1.0f;
-		bMaxValueFound = true;
+		if (batch._round[*pos] == batch._nRound) return false; // used by another collapse
 	}
-	else
+	for (pos = verts.begin(); pos != verts.end(); ++pos)
+	{
+		batch._round[*pos] = batch._nRound;
+	}
+
+	// The "to vertex" gets the triangles of the "from vertex", & their 
+	// vertices as neighbors, & each of those vertices gets the "to vertex"
+	// as a neighbor.
+	int nNewTris = 0;
+	int nNewVerts = 0;
+	const AdjacencyRow fromTris = mesh.getTriNeighbors(ec._vfrom);
+	for (const int* pt = fromTris.begin(); pt != fromTris.end(); ++pt)
 	{
-		// now go through all triangles next to vertex, 
-		set<int>::iterator pos2;
-		for (pos2 = tneighbors.begin(); pos2 != tneighbors.end(); ++pos2) 
+		const triangle& t = mesh.getTri(*pt);
+		if (!t.isActive()) continue;
+
+		if (!mesh.hasTriNeighbor(ec._vto, *pt)) ++nNewTris;
+
+		for (int k = 0; k < 3; ++k)
 		{
-			float min = 1;
-			int triIndex = *pos2;
-			triangle& t = mesh.getTri(triIndex);
-			if (!t.isActive()) continue;
+			const int v = t.getVertIndex(k);
+			if (v == ec._vto) continue;
 
-			bMinValueFound = false;
-			set<int>::iterator pos3;
-			for (pos3 = adjfaces.begin(); pos3 != adjfaces.end(); ++pos3) 
+			if (!mesh.hasVertNeighbor(ec._vto, v)) ++nNewVerts;
+			if (!mesh.hasVertNeighbor(v, ec._vto))
 			{
-				int triIndex3 = *pos3;
-				triangle& t3 = mesh.getTri(triIndex3);
-				if (!t3.isActive()) continue;
-				Vec3 n(t.getNormal());
-				Vec3 n2(t3.getNormal());
-				float dot = n.dot(n2); // cross product of face next to vertex & face along edge
-				float value = (1.0f - dot) * 0.5f; // don't really need to mult. by 0.5, unless want value < 1.0
-				if (value < min)
-				{
-					min = value;
-					bMinValueFound = true;
+				mesh.reserveVertNeighbors(v, mesh.getVertNeighbors(v).size() + 1);
+			}
+		}
+	}
+	mesh.reserveTriNeighbors(ec._vto, mesh.getTriNeighbors(ec._vto).size() + nNewTris);
+	mesh.reserveVertNeighbors(ec._vto, mesh.getVertNeighbors(ec._vto).size() + nNewVerts);
+
+	// It also gets the edges of the "from vertex"
+	if (edges)
+	{
+		edges->_vertEdges.reserve(ec._vto, edges->_vertEdges.row(ec._vto).size() + 
+										   edges->_vertEdges.row(ec._vfrom).size());
+	}
+	return true;
+}
+
+// Add the edge collapses of a batch to the list, in the order they were
+// picked, until a limit is reached.  Returns false if one was.
+bool PMesh::appendBatch(const CollapseBatch &batch, CollapseHistory &history,
+						int &nCollapses, int &nVisTris)
+{
+	for (size_t i = 0; i < batch._collapses.size(); ++i)
+	{
+		if (limitReached(batch._costs[i], nCollapses, nVisTris)) return false;
+
+		const EdgeCollapse &ec = batch._collapses[i];
+		history.append(ec);
+		++nCollapses;
+		nVisTris -= ec._trisRemoved.size();
+	}
+	return true;
+}
+
+// Build the list of edge collapses in parallel, from the heap of vertices
+template <class Cost>
+void PMesh::buildBatchedEdgeCollapseList(Mesh &mesh, 
+										 CollapseHistory &history,
+										 CostHeap &vertHeap, int nVisTris)
+{
+	CollapseBatch batch;
+	batch._round.assign(mesh.getNumVerts(), -1);
+	batch._nRound = -1;
+
+	vector<int> deferred; // candidates which overlap a collapse in the batch
+	vector<int> costVerts; // vertices whose costs are recalculated
+	int nCollapses = 0;
+	int i;
+
+	for (;;)
+	{
+		// Take the cheapest vertices from the heap
+		int maxCandidates;
+		startBatch(batch, vertHeap.size(), maxCandidates);
+		while ((int) batch._candidates.size() < maxCandidates && !vertHeap.empty())
+		{
+			batch._candidates.push_back(vertHeap.top());
+			batch._candidateCosts.push_back(vertHeap.topCost());
+			vertHeap.erase(vertHeap.top());
+		}
+		if (batch._candidates.empty()) break;
+
+		// Find the "to vertex" of each one, & the vertices around it
+		const int nCandidates = (int) batch._candidates.size();
+		batch._candidateCollapses.resize(nCandidates);
+		batch._bBadCandidate.resize(nCandidates);
+		batch._candidateVerts.resize(nCandidates);
+		batch._nCandidateTrisRemoved.resize(nCandidates);
+
+#pragma omp parallel
+		{
+			CollapseScratch scratch;
+
+#pragma omp for schedule(dynamic, 64)
+			for (i = 0; i < nCandidates; ++i)
+			{
+				EdgeCollapse &ec = batch._candidateCollapses[i];
+				bool bBadVertex = false;
+				insureEdgeCollapseValid<Cost>(ec, mesh.getVertex(batch._candidates[i]), mesh, 
+											  bBadVertex, scratch);
+
+				batch._bBadCandidate[i] = bBadVertex;
+				if (!bBadVertex)
+				{
+					findCollapseVerts(ec, mesh, batch._candidateVerts[i], batch._nCandidateTrisRemoved[i]);
+				}
+			}
+		}
+
+		// The candidates which aren't picked go back in the heap
+		const bool bLastBatch = !pickBatch(mesh, batch, NULL, nCollapses, nVisTris, deferred);
+		vector<int>::const_iterator pos;
+		for (pos = deferred.begin(); pos != deferred.end(); ++pos)
+		{
+			const int v = batch._candidates[*pos];
+			vertHeap.push(v, mesh.getVertex(v).getCost());
+		}
+
+		// Collapse the edges.  Each collapse changes its own triangles, &
+		// the rows & corners of its own vertices.
+		const int nBatch = (int) batch._collapses.size();
+		batch._affectedVerts.resize(nBatch);
+
+#pragma omp parallel
+		{
+			CollapseScratch scratch;
+
+#pragma omp for schedule(dynamic)
+			for (i = 0; i < nBatch; ++i)
+			{
+				EdgeCollapse &ec = batch._collapses[i];
+				vector<int> &affectedVerts = batch._affectedVerts[i];
+
+				updateTriangles(ec, mesh.getVertex(ec._vfrom), affectedVerts, mesh, scratch._triNeighbors);
+				mesh.getCorners().relinkVert(mesh, ec._vto, scratch._ring);
+
+				vector<int>::const_iterator mappos;
+				for (mappos = affectedVerts.begin(); mappos != affectedVerts.end(); ++mappos)
+				{
+					updateAffectedVertNeighbors(mesh.getVertex(*mappos), ec, affectedVerts, mesh);
 				}
 			}
+		}
+
+		// The corners around triangles w/ no area may be shared w/ another
+		// collapse, so they're linked one collapse at a time.
+		costVerts.clear();
+		for (i = 0; i < nBatch; ++i)
+		{
+			relinkRemovedTriCorners(batch._collapses[i], mesh);
+			costVerts.insert(costVerts.end(), batch._affectedVerts[i].begin(),
+							 batch._affectedVerts[i].end());
+		}
+
+		// Reset the costs of the affected vertices, then update the heap
+		const int nCostVerts = (int) costVerts.size();
+
+#pragma omp parallel
+		{
+			CollapseScratch scratch;
+
+#pragma omp for schedule(dynamic, 64)
+			for (i = 0; i < nCostVerts; ++i)
+			{
+				Cost::vertCost(*this, mesh, mesh.getVertex(costVerts[i]), scratch);
+			}
+		}
+
+		for (i = 0; i < nCostVerts; ++i)
+		{
+			removeVertIfNecessary(mesh.getVertex(costVerts[i]), vertHeap, mesh);
+		}
+
+		if (!appendBatch(batch, history, nCollapses, nVisTris) || bLastBatch) break;
+	}
+}
+
+// Build the list of edge collapses in parallel, from the heap of edges
+template <class Cost>
+void PMesh::buildBatchedQuadricEdgeCollapseList(Mesh &mesh, CollapseHistory &history,
+												QuadricEdges &edges, int nVisTris)
+{
+	CollapseBatch batch;
+	batch._round.assign(mesh.getNumVerts(), -1);
+	batch._nRound = -1;
+
+	vector<int> deferred; // candidates which overlap a collapse in the batch
+	vector<int> edgeRound(edges._verts.size() / 2, -1); // last round in which each edge was recosted
+	vector<int> costEdges; // edges whose costs are recalculated
+	vector<double> costs;
+	int nCollapses = 0;
+	int i;
+
+	for (;;)
+	{
+		// Take the cheapest edges from the heap
+		int maxCandidates;
+		startBatch(batch, edges._heap.size(), maxCandidates);
+		while ((int) batch._candidates.size() < maxCandidates && !edges._heap.empty())
+		{
+			batch._candidates.push_back(edges._heap.top());
+			batch._candidateCosts.push_back(edges._heap.topCost());
+			edges._heap.erase(edges._heap.top());
+		}
+		if (batch._candidates.empty()) break;
+
+		// Find the vertices around each one
+		const int nCandidates = (int) batch._candidates.size();
+		batch._candidateCollapses.resize(nCandidates);
+		batch._bBadCandidate.assign(nCandidates, false);
+		batch._candidateVerts.resize(nCandidates);
+		batch._nCandidateTrisRemoved.resize(nCandidates);
+
+#pragma omp parallel for schedule(dynamic, 64)
+		for (i = 0; i < nCandidates; ++i)
+		{
+			EdgeCollapse &ec = batch._candidateCollapses[i];
+			ec._vfrom = edges._verts[2 * batch._candidates[i]];
+			ec._vto = edges._verts[2 * batch._candidates[i] + 1];
+			findCollapseVerts(ec, mesh, batch._candidateVerts[i], batch._nCandidateTrisRemoved[i]);
+		}
+
+		// The candidates which aren't picked go back in the heap
+		const bool bLastBatch = !pickBatch(mesh, batch, &edges, nCollapses, nVisTris, deferred);
+		vector<int>::const_iterator pos;
+		for (pos = deferred.begin(); pos != deferred.end(); ++pos)
+		{
+			edges._heap.push(batch._candidates[*pos], batch._candidateCosts[*pos]);
+		}
+
+		// Collapse the edges.  Each collapse changes its own triangles, 
+		// the rows & corners of its own vertices, & its own edges.
+		const int nBatch = (int) batch._collapses.size();
+		batch._affectedVerts.resize(nBatch);
+		batch._removedEdges.resize(nBatch);
+
+#pragma omp parallel
+		{
+			CollapseScratch scratch;
+
+#pragma omp for schedule(dynamic)
+			for (i = 0; i < nBatch; ++i)
+			{
+				EdgeCollapse &ec = batch._collapses[i];
+				vector<int> &affectedVerts = batch._affectedVerts[i];
+				batch._removedEdges[i].clear();
+
+				vertex to = mesh.getVertex(ec._vto);
+				vertex from = mesh.getVertex(ec._vfrom);
+				placeToVertex<Cost>(ec, mesh);
+				setToVertexQuadric<Cost>(to, from);
+
+				updateTriangles(ec, from, affectedVerts, mesh, scratch._triNeighbors);
+				updateMovedTris(ec, mesh);
+				mesh.getCorners().relinkVert(mesh, ec._vto, scratch._ring);
+				moveQuadricEdges(ec, affectedVerts, mesh, edges, batch._removedEdges[i]);
+			}
+		}
+
+		// The corners around triangles w/ no area, & the other ends of the
+		// removed edges, may be shared w/ another collapse, so they're 
+		// updated one collapse at a time.
+		for (i = 0; i < nBatch; ++i)
+		{
+			relinkRemovedTriCorners(batch._collapses[i], mesh);
+
+			vector<int>::const_iterator pe;
+			for (pe = batch._removedEdges[i].begin(); pe != batch._removedEdges[i].end(); ++pe)
+			{
+				removeQuadricEdge(edges, *pe);
+			}
+		}
+
+		// The "to vertices" have new quadrics, so their edges have new
+		// costs.  (An edge may join two "to vertices".)
+		costEdges.clear();
+		for (i = 0; i < nBatch; ++i)
+		{
+			const AdjacencyRow toRow = edges._vertEdges.row(batch._collapses[i]._vto);
+			for (const int* pe = toRow.begin(); pe != toRow.end(); ++pe)
+			{
+				if (edgeRound[*pe] == batch._nRound) continue;
+				edgeRound[*pe] = batch._nRound;
+				costEdges.push_back(*pe);
+			}
+		}
+
+		const int nCostEdges = (int) costEdges.size();
+		costs.resize(nCostEdges);
+
+#pragma omp parallel for schedule(dynamic, 64)
+		for (i = 0; i < nCostEdges; ++i)
+		{
+			costs[i] = orientQuadricEdge<Cost>(mesh, &edges._verts[2 * costEdges[i]]);
+		}
+
+		for (i = 0; i < nCostEdges; ++i)
+		{
+			setQuadricEdgeCost(edges, costEdges[i], costs[i]);
+		}
+
+		if (!appendBatch(batch, history, nCollapses, nVisTris) || bLastBatch) break;
+	}
+}
+
+// Where most of the work of the program is done.
+// This will create a list of edge collapses.  Each edge collapse
+// is a set of 2 vertices, a from vertex & a to vertex.  The from
+// vertex will be collapsed to the to vertex.  No new vertices are created,
+// only vertices in the original mesh are used.
+void PMesh::createEdgeCollapseList()
+{
+	// okay, get list of verts, tris
+	// for each vert, calc cost
+	// add to edge collapse list
+
+	// Copy the original mesh
+	_newmesh = *_mesh;
+
+	_history.clear(); // empty list
+
+	int nVerts = _newmesh.getNumVerts();
+	int nTri = _newmesh.getNumTriangles();
+
+	_nVisTriangles = nTri; // number of visible triangles
+	
+	// assert each vert is active -- sanity check
+
+#ifndef NDEBUG
+	assertEveryVertActive(nVerts, nTri, _newmesh);
+#endif
+
+	switch (_cost)
+	{
+	case SHORTEST:
+		createVertCollapseList<ShortestCost>(nTri);
+		break;
+	case MELAX:
+		createVertCollapseList<MelaxCost>(nTri);
+		break;
+	case QUADRIC:
+		createQuadricCollapseList<QuadricCost>(nTri);
+		break;
+	case QUADRICTRI:
+		createQuadricCollapseList<QuadricTriCost>(nTri);
+		break;
+	default:
+		assert(false);
+		break;
+	};
+
+#ifndef NDEBUG
+	assertTriNormalsMatch(_newmesh);
+#endif
+
+	_history.trim();
+	renumberInCollapseOrder();
+
+	_newmesh = _orderedMesh;
+	int i;
+	for (i = 0; i < nTri; ++i)
+	{
+		_newmesh.getTri(i).setActive(true);
+	}
+
+	// The index buffer starts w/ every triangle, each in its own slot
+	_indices.resize(3 * (size_t) nTri);
+	_triSlots.resize(nTri);
+	_slotTris.resize(nTri);
+	for (i = 0; i < nTri; ++i)
+	{
+		_newmesh.getTri(i).getVerts(_indices[3 * i], _indices[3 * i + 1], _indices[3 * i + 2]);
+		_triSlots[i] = _slotTris[i] = i;
+	}
+	_dirtyRanges.clear();
+	addDirtyRange(0, nTri);
+
+	_meshVersion = 0;
+	_smoothVertsVersion = _flatVertsVersion = -1;
+
+	// The # of visible triangles after each # of edge collapses
+	_visTris.resize(_history.size() + 1);
+	_visTris[0] = nTri;
+	for (int k = 0; k < _history.size(); ++k)
+	{
+		_visTris[k + 1] = _visTris[k] - _history[k]._nTrisRemoved;
+	}
+	_checkpoints.clear();
+
+	// no edge collapses have been done yet
+	_nextCollapse = 0;
+}
+
+
+// Each triangle is removed by at most one edge collapse, & each vertex
+// is the "from vertex" of at most one.  So if the ones which are never
+// removed come first, followed by those of the last collapse, & so on
+// back to the first collapse, the ones left after k collapses are at
+// the start.  (Hoppe's progressive meshes are stored the same way.)
+void PMesh::renumberInCollapseOrder()
+{
+	const int nVerts = _mesh->getNumVerts();
+	const int nTris = _mesh->getNumTriangles();
+	const int nCollapses = _history.size();
+	int i, n;
+
+	vector<int> newVert(nVerts, 0);
+	vector<int> newTri(nTris, 0);
+
+	// Mark the triangles & vertices which are collapsed
+	for (n = 0; n < nCollapses; ++n)
+	{
+		const AdjacencyRow trisRemoved = _history.trisRemoved(n);
+		for (const int* tripos = trisRemoved.begin(); tripos != trisRemoved.end(); ++tripos)
+		{
+			newTri[*tripos] = -1;
+		}
+		newVert[_history[n]._vfrom] = -1;
+	}
+
+	_triOrder.clear();
+	_triOrder.reserve(nTris);
+	for (i = 0; i < nTris; ++i)
+	{
+		if (newTri[i] >= 0) _triOrder.push_back(i);
+	}
+	_vertOrder.clear();
+	_vertOrder.reserve(nVerts);
+	for (i = 0; i < nVerts; ++i)
+	{
+		if (newVert[i] >= 0) _vertOrder.push_back(i);
+	}
+	for (n = nCollapses - 1; n >= 0; --n)
+	{
+		const AdjacencyRow trisRemoved = _history.trisRemoved(n);
+		_triOrder.insert(_triOrder.end(), trisRemoved.begin(), trisRemoved.end());
+		_vertOrder.push_back(_history[n]._vfrom);
+	}
+	assert((int) _triOrder.size() == nTris && (int) _vertOrder.size() == nVerts);
+
+	for (i = 0; i < nTris; ++i) newTri[_triOrder[i]] = i;
+	for (i = 0; i < nVerts; ++i) newVert[_vertOrder[i]] = i;
+
+	_orderedMesh = *_mesh;
+	_orderedMesh.renumber(newVert, newTri);
+	_history.renumber(newVert, newTri);
+}
+
+
+// Create the list of edge collapses from a heap of vertices, ordered
+// by edge collapse cost.
+template <class Cost>
+void PMesh::createVertCollapseList(int nVisTris)
+{
+	CostHeap vertHeap;
+
+	// Go through, calc cost here for all vertices
+	calcEdgeCollapseCosts<Cost>(vertHeap, _newmesh.getNumVerts(), _newmesh);
+
+	// For all vertices:
+	//	find lowest cost
+	//	store the edge collapse structure
+	//	update all verts, triangles affected by the edge collapse
+	if (_bParallel)
+	{
+		buildBatchedEdgeCollapseList<Cost>(_newmesh, _history, vertHeap, nVisTris);
+	}
+	else
+	{
+		buildEdgeCollapseList<Cost>(_newmesh, _history, vertHeap, nVisTris);
+	}
+}
+
+// Create the list of edge collapses from a heap of edges, ordered by
+// edge collapse cost.
+template <class Cost>
+void PMesh::createQuadricCollapseList(int nVisTris)
+{
+	// calculate all 4x4 Q matrices for each vertex 
+	_newmesh.allocQuadrics();
+	calcAllQMatrices(_newmesh, Cost::TRI_AREA);
+
+	QuadricEdges edges;
+	buildQuadricEdges<Cost>(_newmesh, edges);
+
+	// For all edges:
+	//	find lowest cost
+	//	store the edge collapse structure
+	//	update all verts, triangles, edges affected by the edge collapse
+	if (_bParallel)
+	{
+		buildBatchedQuadricEdgeCollapseList<Cost>(_newmesh, _history, edges, nVisTris);
+	}
+	else
+	{
+		buildQuadricEdgeCollapseList<Cost>(_newmesh, _history, edges, nVisTris);
+	}
+}
+
+// Find the border edges of triangles first to last - 1, from the corners
+// which face them.  Each edge used by only one active triangle is found
+// once, w/ that triangle.
+static void findBorderEdges(const Mesh &mesh, int first, int last, vector<border> &borderEdges)
+{
+	const CornerTable& corners = mesh.getCorners();
+	for (int t = first; t < last; ++t)
+	{
+		const triangle& tri = mesh.getTri(t);
+		if (!tri.isActive()) continue;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			// corner k faces the edge between the triangle's other two vertices
+			const int v1 = tri.getVertIndex((k + 1) % 3);
+			const int v2 = tri.getVertIndex((k + 2) % 3);
+			if (v1 == v2 || !corners.isBorderEdge(mesh, 3 * t + k, v1, v2)) continue;
+
+			// store the smaller index first
+			border b;
+			b.triIndex = t;
+			b.vert1 = (v1 < v2) ? v1 : v2;
+			b.vert2 = (v1 < v2) ? v2 : v1;
+			borderEdges.push_back(b);
+		}
+	}
+}
+
+// Calculate the 4x4 Q Matrix used for the Quadric calculation
+// for each vertex
+void PMesh::calcAllQMatrices(Mesh& mesh, bool bUseTriArea)
+{
+	const int nVerts = mesh.getNumVerts();
+	const int nTri = mesh.getNumTriangles();
+
+	// Each triangle's area is used by its three vertices, so
+	// calculate it once.
+	vector<float> triAreas;
+	if (bUseTriArea && nTri > 0)
+	{
+		triAreas.resize(nTri);
+		int t;
+#pragma omp parallel for
+		for (t = 0; t < nTri; ++t)
+		{
+			triAreas[t] = mesh.getTri(t).calcArea();
+		}
+	}
+
+	// The vertices & triangles are split into chunks, which are done in
+	// parallel.  Each vertex sums its triangles' planes in the same order
+	// as before, & the border edges of each chunk are kept in order, so 
+	// the results don't depend on the number of threads.
+	int nChunks = 1;
+#ifdef _OPENMP
+	nChunks = 4 * omp_get_max_threads(); // a few chunks per thread to balance the load
+#endif
+	if (nChunks > nVerts) nChunks = nVerts;
+	if (nChunks < 1) nChunks = 1;
+
+	vector< vector<border> > chunkBorderEdges(nChunks);
+	int k;
+#pragma omp parallel for schedule(dynamic)
+	for (k = 0; k < nChunks; ++k)
+	{
+		const int first = (int) ((double) nVerts * k / nChunks);
+		const int last = (int) ((double) nVerts * (k + 1) / nChunks);
+		for (int i = first; i < last; ++i)
+		{
+			vertex currVert = mesh.getVertex(i);
+
+			currVert.calcQuadric(mesh, triAreas.empty() ? NULL : &triAreas[0]);
+		}
+
+		findBorderEdges(mesh, (int) ((double) nTri * k / nChunks), 
+						(int) ((double) nTri * (k + 1) / nChunks), chunkBorderEdges[k]);
+	}
+
+	// Sort the border edges by their vertices.  An edge is only found 
+	// more than once if it's non-manifold, & then the first triangle 
+	// found for it is the one which is used.
+	vector<border> borderEdges;
+	for (k = 0; k < nChunks; ++k)
+	{
+		borderEdges.insert(borderEdges.end(), chunkBorderEdges[k].begin(), chunkBorderEdges[k].end());
+	}
+	stable_sort(borderEdges.begin(), borderEdges.end());
+	borderEdges.erase(unique(borderEdges.begin(), borderEdges.end()), borderEdges.end());
+
+	// Keep the mesh borders from being "eaten away".
+	if (!borderEdges.empty())
+	{
+		applyBorderPenalties(borderEdges, mesh);
+	}
+}
+
+// Border penalties are used to prevent mesh edges from collapsing
+// too soon.  This causes holes & T-junctions in the mesh to expand,
+// and causes the edges of the mesh to be "eaten away".  2-manifold,
+// closed meshes will not need to worry about this, and won't have
+// any border penalties.
+void PMesh::applyBorderPenalties(const vector<border> &borderEdges, Mesh &mesh)
+{
+	vector<border>::const_iterator pos;
+
+	for (pos = borderEdges.begin(); pos != borderEdges.end(); ++pos) 
+	{
+		// First, determine the plane equation of plane perpendicular 
+		// to the edge triangle.
+
+		border edgeInfo = *pos;
+
+		vertex v1 = mesh.getVertex(edgeInfo.vert1);
+		vertex v2 = mesh.getVertex(edgeInfo.vert2);
+
+		Vec3 &vec1 = v1.getXYZ();
+		Vec3 &vec2 = v2.getXYZ();
+
+		Vec3 edge = vec1 - vec2;
+
+		triangle &tri = mesh.getTri(edgeInfo.triIndex);
+		Vec3 normal = tri.getNormalVec3();
+
+		Vec3 abc = edge.unitcross(normal);
+		float &a = abc.x;
+		float &b = abc.y;
+		float &c = abc.z;
+
+		float d = -(abc.dot(vec1));
+
+
+		Quadric constraint(a, b, c, d);
+		constraint *= BOUNDARY_WEIGHT;
+
+		// Now add the constraint quadric to the quadrics for both of the 
+		// vertices.
+		v1.getQuadric() += constraint;
+		v2.getQuadric() += constraint;
+	}
+}
+
+
+// Calculate the cost of collapsing this vertex using the
+// "shortest edge" method.
+double PMesh::shortEdgeCollapseCost(Mesh& m, vertex v)
+{
+	// get list of all active neighbors
+	// calculate shortest edge
+	// what if no neighbors??
+	// return cost
+	float mincost = FLT_MAX; // from float.h
+	bool bNeighborFound = false;
+
+	const AdjacencyRow neighbors = m.getVertNeighbors(v.getIndex());
+	const int* pos;
+	for (pos = neighbors.begin(); pos != neighbors.end(); ++pos) 
+	{
+		vertex n = m.getVertex(*pos);
+		if (!n.isActive()) continue;
+		if (n == v) continue;
+
+		// calc cost
+		Vec3 s = v.getXYZ() - n.getXYZ();
+		float cost = s.length();
+
+		if (cost < mincost)
+		{
+			bNeighborFound = true;
+			mincost = cost;
+			v.setEdgeRemoveCost(cost);
+			v.setMinCostEdgeVert(*pos);
+			assert(v.minCostEdgeVert() >= 0 && v.minCostEdgeVert() < m.getNumVerts());
+		}
+	}
+	
+	if (bNeighborFound) {
+		return mincost;
+	} else {
+		return FLT_MAX; // vertex not connected to an edge
+	}
+}
+
+
+// Helper function for melaxCollapseCost().  This function
+// will loop through all the triangles to which this vertex
+// belongs.
+void PMesh::calcMelaxMaxValue(const vector<Vec3> &edgeNormals, 
+							  bool bBorder, const vector<Vec3> &faceNormals,
+								float &retmaxValue, 
+								bool &bMaxValueFound)
+{
+	if (edgeNormals.size() > 1 && bBorder)
+	{
+		retmaxValue = 1.0f;
+		bMaxValueFound = true;
+	}
+	else
+	{
+		// now go through all triangles next to vertex.  Each one's value
+		// is its smallest value w/ a triangle along the edge, if that's
+		// less than 1, & retmaxValue is raised to the largest of these.
+		// (None can raise it if it's at least 1.)  The loop is over every
+		// pair of triangles, so it's written w/o branches.
+		float maxValue = retmaxValue;
+		if (maxValue >= 1) return;
+
+		vector<Vec3>::const_iterator pos2;
+		for (pos2 = faceNormals.begin(); pos2 != faceNormals.end(); ++pos2) 
+		{
+			float min = 1;
+			const Vec3& n = *pos2;
+
+			vector<Vec3>::const_iterator pos3;
+			for (pos3 = edgeNormals.begin(); pos3 != edgeNormals.end(); ++pos3) 
+			{
+				const Vec3& n2 = *pos3;
+				float dot = n.dot(n2); // cross product of face next to vertex & face along edge
+				float value = (1.0f - dot) * 0.5f; // don't really need to mult. by 0.5, unless want value < 1.0
+				min = (value < min) ? value : min;
+			}
+
+			const float faceValue = (min < 1) ? min : -FLT_MAX;
+			maxValue = (faceValue > maxValue) ? faceValue : maxValue;
+		}
+
+		if (maxValue > retmaxValue) {
+			retmaxValue = maxValue;
+			bMaxValueFound = true;
+		}
+	}
+}
+
+// Calculate the cost of collapsing this vertex using the
+// "Stan Melax PolyChop" method.
+double PMesh::melaxCollapseCost(Mesh& mesh, vertex v, CollapseScratch &scratch)
+{
+	const AdjacencyRow vneighbors = mesh.getVertNeighbors(v.getIndex());
+	const AdjacencyRow tneighbors = mesh.getTriNeighbors(v.getIndex());
+	const int* pos;
+	float retmaxValue = -2.0;
+	float mincost = 1e6;
+
+	// Get the edges around this vertex, sorted by the neighbor at the
+	// other end of each edge.
+	const vector<CornerTable::RingEdge> &ring = scratch._ring;
+	CornerTable::getRing(mesh, v.getIndex(), scratch._ring);
+	vector<CornerTable::RingEdge>::const_iterator edge = ring.begin();
+
+	// Is the vertex on the border, i.e. is one of its edges used by only
+	// one triangle?
+	bool bBorder = false;
+	for (edge = ring.begin(); edge != ring.end() && !bBorder; ++edge)
+	{
+		bBorder = mesh.getCorners().isBorderEdge(mesh, edge->corner, v.getIndex(), edge->vert);
+	}
+	edge = ring.begin();
+
+	// The normals of the active triangles around the vertex, which are
+	// compared w/ the triangles on each edge
+	vector<Vec3> &faceNormals = scratch._faceNormals;
+	faceNormals.clear();
+	for (pos = tneighbors.begin(); pos != tneighbors.end(); ++pos)
+	{
+		const triangle& t = mesh.getTri(*pos);
+		if (t.isActive()) faceNormals.push_back(t.getNormalVec3());
+	}
+
+	vector<Vec3> &edgeNormals = scratch._edgeNormals;
+
+	for (pos = vneighbors.begin(); pos != vneighbors.end(); ++pos) 
+	{
+		if (v.getIndex() == *pos) continue; // vertex has itself as a neighbor, by mistake //!NEW
+
+		// get adj. faces:  the triangles on the edge to this neighbor
+		edgeNormals.clear();
+		int lastTri = -1;
+		while (edge != ring.end() && edge->vert < *pos) ++edge;
+		for (; edge != ring.end() && edge->vert == *pos; ++edge)
+		{
+			const int triIndex = CornerTable::triOf(edge->corner);
+			if (triIndex != lastTri)
+			{
+				// triangle contains both vertex & vertex neighbor
+				edgeNormals.push_back(mesh.getTri(triIndex).getNormalVec3());
+				lastTri = triIndex;
+			}
+		}
+
+		bool bMaxValueFound  = false;
+
+		// If there is only 1 face shared between the 2 vertices, then the 
+		// edge is at the edge of the model.  Set it equal to 1.0, which is
+		// the max value of curvature we can give it.  We do this so the 
+		// edges of the model won't collapse inward.  Note that if the model 
+		// has a nice manifold surface, every edge will be shared by  at least 2
+		// triangles, and it won't be an issue.
+
+		// This idea comes from Stan Melax's follup up web page to his PolyChop
+		// algorithm. (http://www.melax.com/polychop/feedback/index.html)
+		// or (http://www.cs.ualberta.ca/~melax/polychop/feedback)
+		calcMelaxMaxValue(edgeNormals, bBorder, faceNormals,
+							retmaxValue, bMaxValueFound);
+		if (bMaxValueFound)
+		{
+			Vec3 v1 = v.getXYZ();
+			Vec3 v2 = mesh.getVertex(*pos).getXYZ();
+			Vec3 v3 = v1 - v2;
+			retmaxValue *= v3.length();
 			
-			if (bMinValueFound && min > retmaxValue) {
-				retmaxValue = min;
-				bMaxValueFound = true;
+			if (retmaxValue < mincost) 
+			{
+				mincost = retmaxValue;
+				v.setEdgeRemoveCost(retmaxValue);
+				v.setMinCostEdgeVert(*pos);
 			}
 		}
 	}
+	return mincost;
+}
+
+// Calculate the cost of collapsing an edge using the
+// "Garland & Heckbert Quadrics" method.  The edge can be collapsed
+// either way, so keep the cheaper one:  ev is swapped if collapsing
+// ev[1] to ev[0] is cheaper.
+template <class Cost>
+double PMesh::orientQuadricEdge(Mesh &mesh, int* ev)
+{
+	Vec3 pos;
+	return orientQuadricEdge<Cost>(mesh, ev, pos);
+}
+
+template <class Cost>
+double PMesh::orientQuadricEdge(Mesh &mesh, int* ev, Vec3 &pos)
+{
+	vertex v1 = mesh.getVertex(ev[0]);
+	vertex v2 = mesh.getVertex(ev[1]);
+
+	// add the two quadrics
+	const Quadric Qsum = v1.getQuadric() + v2.getQuadric();
+
+	double triArea = 0;
+	if (Cost::TRI_AREA)
+	{
+		triArea = v1.getQuadricSummedTriArea() + v2.getQuadricSummedTriArea();
+	}
+
+	// Collapsing v1 to v2 leaves the vertex at v2's position, & vice versa
+	double cost = calcQuadricError<Cost>(Qsum, v2.getXYZ(), triArea);
+	const double reverseCost = calcQuadricError<Cost>(Qsum, v1.getXYZ(), triArea);
+	pos = v2.getXYZ();
+	if (reverseCost < cost)
+	{
+		cost = reverseCost;
+		pos = v1.getXYZ();
+		const int tmp = ev[0];
+		ev[0] = ev[1];
+		ev[1] = tmp;
+	}
+
+	// The vertex which is left can go anywhere, so try the best point,
+	// then the midpoint of the edge.  The "to vertex" is still the one
+	// w/ the smaller error, since it's where a failed try leaves it.
+	if (PLACE_OPTIMAL == _placement)
+	{
+		Vec3 tryPos[2];
+		int nTries = 0;
+		if (Qsum.optimize(tryPos[nTries])) ++nTries;
+		tryPos[nTries++] = (v1.getXYZ() + v2.getXYZ()) * 0.5f;
+
+		for (int k = 0; k < nTries; ++k)
+		{
+			const double tryCost = calcQuadricError<Cost>(Qsum, tryPos[k], triArea);
+			if (tryCost < cost)
+			{
+				cost = tryCost;
+				pos = tryPos[k];
+			}
+		}
+	}
+	return cost;
+}
+
+// Calculate the cost of an edge, & update it in the heap
+template <class Cost>
+void PMesh::calcQuadricEdgeCost(Mesh &mesh, QuadricEdges &edges, int e)
+{
+	setQuadricEdgeCost(edges, e, orientQuadricEdge<Cost>(mesh, &edges._verts[2 * e]));
+}
+
+// Calculate the quadric error if using that edge collapse
+// algorithm.  We're calculating
+//
+//  T    
+// v  Q v
+//
+
+// This is the vertex multiplied by the 4x4 Q matrix, multiplied
+// by the vertex again (see Quadric::evaluate).
+template <class Cost>
+double PMesh::calcQuadricError(const Quadric& Qsum, const Vec3& v3, double triArea)
+{
+	double cost = Qsum.evaluate(v3);
+
+	if (Cost::TRI_AREA && triArea != 0)
+	{
+		cost /= triArea;
+	}
+
+	return cost;
+}
+
+// Collapse an edge (remove one vertex & edge, and possibly some triangles.)
+bool PMesh::collapseEdge()
+{
+	// _nextCollapse is always the next collapse to perform
+	if (_nextCollapse == _history.size()) return false; // no more edge collapses in list
+	return setCollapseIndex(_nextCollapse + 1);
+}
+
+// Split a vertex (add one vertex & edge, and possibly some triangles.)
+bool PMesh::splitVertex()
+{
+	// _nextCollapse is always the next collapse to perform.
+	// But we don't want to collapse, we want to undo the previous
+	// collapse, unless we're at the front of the list, in which case
+	// there are no collapses to undo (the mesh is fully displayed w/o
+	// any collapses).
+	if (_nextCollapse == 0) return false;
+	return setCollapseIndex(_nextCollapse - 1);
+}
+
+// Do or undo the edge collapses between the current one & k.  Only the
+// triangles are changed as each collapse is done.  The vertices which 
+// need new normals are gathered, & their normals are recalculated at 
+// the end, each one once.
+bool PMesh::setCollapseIndex(int k)
+{
+	bool bInRange = true;
+	if (k < 0)
+	{
+		k = 0;
+		bInRange = false;
+	}
+	else if (k > _history.size())
+	{
+		k = _history.size();
+		bInRange = false;
+	}
+
+	vector<int> &affectedVerts = _affectedVerts; // vertices affected by these edge collapses
+	vector<int> &removedVerts = _removedVerts; // "from vertices" which are collapsed
+	affectedVerts.clear();
+	removedVerts.clear();
+
+	// Start from the nearest checkpoint, if that saves replaying more
+	// than an interval's worth of collapses.  (Restoring one costs about
+	// as much as replaying an interval.)  After view-dependent
+	// refinement, always start over, from the original mesh if there are
+	// no checkpoints.
+	if (!_checkpoints.empty())
+	{
+		int c = (k + _checkpointInterval / 2) / _checkpointInterval;
+		if (c >= (int) _checkpoints.size()) c = (int) _checkpoints.size() - 1;
+
+		if (_bViewRefined ||
+			abs(k - _checkpoints[c]._nCollapses) + _checkpointInterval < abs(k - _nextCollapse))
+		{
+			restoreCheckpoint(_checkpoints[c]);
+		}
+	}
+	else if (_bViewRefined)
+	{
+		CollapseCheckpoint original; // every triangle active, & nothing changed
+		original._nCollapses = 0;
+		original._activeTris.assign((_newmesh.getNumTriangles() + 31) / 32, ~0u);
+		restoreCheckpoint(original);
+	}
+
+	for (; _nextCollapse < k; ++_nextCollapse)
+	{
+		applyCollapse(_nextCollapse, affectedVerts);
+		removedVerts.push_back(_history[_nextCollapse]._vfrom);
+	}
+	while (_nextCollapse > k)
+	{
+		--_nextCollapse; // go to previous edge collapse, so we can undo it
+		undoCollapse(_nextCollapse, affectedVerts);
+	}
+
+	// Skip the "from vertices" which were collapsed -- they're no longer active
+	sort(affectedVerts.begin(), affectedVerts.end());
+	affectedVerts.erase(unique(affectedVerts.begin(), affectedVerts.end()), affectedVerts.end());
+	if (!removedVerts.empty())
+	{
+		sort(removedVerts.begin(), removedVerts.end());
+		affectedVerts.erase(set_difference(affectedVerts.begin(), affectedVerts.end(),
+										   removedVerts.begin(), removedVerts.end(),
+										   affectedVerts.begin()), 
+							affectedVerts.end());
+	}
+
+	// redo the vertex normal for the vertices affected.  these are
+	// vertices of triangles which were shifted around as a result
+	// of these edge collapses (or splits).
+	calcVertNormals(affectedVerts);
+
+#ifndef NDEBUG
+	assertTriNormalsMatch(_newmesh);
+	assertVertNormalsMatch(_newmesh);
+#endif
+
+	return bInRange;
 }
 
-// Calculate the cost of collapsing this vertex using the
-// "Stan Melax PolyChop" method.
-double PMesh::melaxCollapseCost(Mesh& mesh, vertex& v)
+// The visible triangles only go down as edge collapses are done, so
+// the fewest collapses which leave at most n are found by binary search.
+bool PMesh::setVisibleTriangleCount(int n)
 {
-	set<int>& vneighbors = v.getVertNeighbors();
-	set<int>& tneighbors = v.getTriNeighbors();
-	set<int>::iterator pos;
-	set<int>::iterator pos2;
-	float retmaxValue = -2.0;
-	float mincost = 1e6;
-	for (pos = vneighbors.begin(); pos != vneighbors.end(); ++pos) 
-	{
-		if (v.getIndex() == *pos) continue; // vertex has itself as a neighbor, by mistake //!NEW
+	int k = (int) (lower_bound(_visTris.begin(), _visTris.end(), n, greater<int>()) - _visTris.begin());
+	if (k > _history.size()) k = _history.size(); // there are always more than n
 
-		// get adj. faces
-		set<int> adjfaces;
-		// get triangle neighbors of this vertex
-		for (pos2 = tneighbors.begin(); pos2 != tneighbors.end(); ++pos2) 
-		{
-			// get triangle
-			int triIndex = *pos2;
-			triangle& t = mesh.getTri(triIndex);
-			if (t.isActive() && t.hasVertex(*pos)) 
-			{
-				adjfaces.insert(triIndex); // triangle contains both vertex & vertex neighbor
-			}
-		}
+	setCollapseIndex(k);
+	return _nVisTriangles <= n;
+}
 
-		bool bMaxValueFound  = false;
+// Replay the edge collapses from the original mesh, & save a checkpoint
+// every nInterval of them.  The vertex normals aren't needed until the
+// end.
+void PMesh::setCheckpointInterval(int nInterval)
+{
+	_checkpoints.clear();
+	_checkpointInterval = (nInterval > 0) ? nInterval : 0;
+	if (0 == _checkpointInterval) return;
 
-		// If there is only 1 face shared between the 2 vertices, then the 
-		// edge is at the edge of the model.  Set it equal to 1.0, which is
-		// the max value of curvature we can give it.  We do this so the 
-		// edges of the model won't collapse inward.  Note that if the model 
-		// has a nice manifold surface, every edge will be shared by  at least 2
-		// triangles, and it won't be an issue.
+	const int nCollapses = _nextCollapse;
+	setCollapseIndex(0);
 
-		// This idea comes from Stan Melax's follup up web page to his PolyChop
-		// algorithm. (http://www.melax.com/polychop/feedback/index.html)
-		// or (http://www.cs.ualberta.ca/~melax/polychop/feedback)
-		calcMelaxMaxValue(mesh, adjfaces, v, tneighbors,
-							retmaxValue, bMaxValueFound);
-		if (bMaxValueFound)
+	for (;;)
+	{
+		_checkpoints.push_back(CollapseCheckpoint());
+		saveCheckpoint(_checkpoints.back());
+
+		if (_history.size() - _nextCollapse < _checkpointInterval) break;
+		for (int i = 0; i < _checkpointInterval; ++i)
 		{
-			Vec3 v1 = v.getXYZ();
-			Vec3 v2 = mesh.getVertex(*pos).getXYZ();
-			Vec3 v3 = v1 - v2;
-			retmaxValue *= v3.length();
-			
-			if (retmaxValue < mincost) 
-			{
-				mincost = retmaxValue;
-				v.setEdgeRemoveCost(retmaxValue);
-				v.setMinCostEdgeVert(*pos);
-			}
+			_affectedVerts.clear();
+			applyCollapse(_nextCollapse, _affectedVerts);
+			++_nextCollapse;
 		}
 	}
-	return mincost;
+
+	// Go back to where we were
+	int c = (nCollapses + _checkpointInterval / 2) / _checkpointInterval;
+	if (c >= (int) _checkpoints.size()) c = (int) _checkpoints.size() - 1;
+	restoreCheckpoint(_checkpoints[c]);
+	setCollapseIndex(nCollapses);
 }
 
-// Calculate the cost of collapsing this vertex using the
-// "Garland & Heckbert Quadrics" method.
-double PMesh::quadricCollapseCost(Mesh& m, vertex& v)
+size_t PMesh::checkpointBytes() const
 {
-	// get list of all active neighbors
-	// calculate quadric cost
-	double mincost = FLT_MAX; // from float.h
-	bool bNeighborFound = false;
-
-	double Q1[4][4];
-	v.getQuadric(Q1);
-
-	set<int>& neighbors = v.getVertNeighbors();
-	set<int>::iterator pos;
-	for (pos = neighbors.begin(); pos != neighbors.end(); ++pos) 
+	size_t nBytes = 0;
+	vector<CollapseCheckpoint>::const_iterator pos;
+	for (pos = _checkpoints.begin(); pos != _checkpoints.end(); ++pos)
 	{
+		nBytes += pos->bytesUsed();
+	}
+	return nBytes;
+}
 
-		vertex& n = m.getVertex(*pos);
-		if (!n.isActive()) continue;
-		if (n == v) continue;
+// Compare the mesh w/ the original one, & save what's different
+void PMesh::saveCheckpoint(CollapseCheckpoint &cp)
+{
+	const int nTris = _newmesh.getNumTriangles();
+	const int nVerts = _newmesh.getNumVerts();
+	const CornerTable& corners = _newmesh.getCorners();
+	const CornerTable& origCorners = _orderedMesh.getCorners();
+	int i;
 
-		double Q2[4][4];
-		double Qsum[4][4];
+	cp._nCollapses = _nextCollapse;
+	cp._activeTris.assign((nTris + 31) / 32, 0);
+	cp._changedTris.clear();
+	cp._changedCorners.clear();
+	cp._movedVerts.clear();
+	cp._movedPositions.clear();
 
-		// add two 4x4 Q matrices
-		n.getQuadric(Q2);
+	for (i = 0; i < nTris; ++i)
+	{
+		const triangle& t = _newmesh.getTri(i);
+		const triangle& orig = _orderedMesh.getTri(i);
+		if (t.isActive()) cp._activeTris[i / 32] |= 1u << (i % 32);
 
-		for(int i = 0; i < 4; ++i) {
-			for ( int j = 0; j < 4; ++j) {
-				Qsum[i][j] = Q1[i][j] + Q2[i][j];
-			}
+		if (t.getVert1Index() != orig.getVert1Index() || 
+			t.getVert2Index() != orig.getVert2Index() || 
+			t.getVert3Index() != orig.getVert3Index())
+		{
+			cp._changedTris.push_back(i);
+			cp._changedTris.push_back(t.getVert1Index());
+			cp._changedTris.push_back(t.getVert2Index());
+			cp._changedTris.push_back(t.getVert3Index());
 		}
+	}
 
-		double triArea = 0;
-		if (QUADRICTRI == _cost)
+	for (i = 0; i < 3 * nTris; ++i)
+	{
+		if (corners.opposite(i) != origCorners.opposite(i))
 		{
-			triArea = v.getQuadricSummedTriArea() + n.getQuadricSummedTriArea();
+			cp._changedCorners.push_back(i);
+			cp._changedCorners.push_back(corners.opposite(i));
 		}
+	}
 
-		// calc cost
-		double cost = calcQuadricError(Qsum, n, triArea);
-
-		if (cost < mincost)
+	for (i = 0; i < nVerts; ++i)
+	{
+		const Vec3& pos = _newmesh.getVertex(i).getXYZ();
+		if (pos != _orderedMesh.getVertex(i).getXYZ())
 		{
-			bNeighborFound = true;
-			mincost = cost;
-			v.setEdgeRemoveCost(cost);
-			v.setMinCostEdgeVert(*pos);
-			assert(v.minCostEdgeVert() >= 0 && v.minCostEdgeVert() < m.getNumVerts());
+			cp._movedVerts.push_back(i);
+			cp._movedPositions.push_back(pos);
 		}
 	}
-	
-	if (bNeighborFound) {
-		return mincost;
-	} else {
-		return FLT_MAX; // vertex not connected to an edge
-	}
+
+	// The checkpoints are kept, so don't keep spare memory
+	vector<int>(cp._changedTris).swap(cp._changedTris);
+	vector<int>(cp._changedCorners).swap(cp._changedCorners);
+	vector<int>(cp._movedVerts).swap(cp._movedVerts);
+	vector<Vec3>(cp._movedPositions).swap(cp._movedPositions);
 }
-		
-// Calculate the quadric error if using that edge collapse
-// algorithm.  We're calculating
-//
-//  T    
-// v  Q v
-//
 
-// This is the vertex multiplied by the 4x4 Q matrix, multiplied
-// by the vertex again.
-double PMesh::calcQuadricError(double Qsum[4][4], vertex& v, double triArea)
+// Start from the original mesh, then change what the checkpoint says is
+// different.  A triangle's normal only depends on where its vertices
+// are, so the normals of the visible triangles are recalculated, & then
+// the normals of all the vertices.
+void PMesh::restoreCheckpoint(const CollapseCheckpoint &cp)
 {
-	double cost;
+	const int nTris = _newmesh.getNumTriangles();
+	const int nVerts = _newmesh.getNumVerts();
+	CornerTable& corners = _newmesh.getCorners();
+	int i;
+
+	// The vertices are moved first, since the triangle normals are
+	// calculated from them
+	for (i = 0; i < nVerts; ++i)
+	{
+		_newmesh.getVertex(i).getXYZ() = _orderedMesh.getVertex(i).getXYZ();
+	}
+	for (i = 0; i < (int) cp._movedVerts.size(); ++i)
+	{
+		_newmesh.getVertex(cp._movedVerts[i]).getXYZ() = cp._movedPositions[i];
+	}
 
-	// 1st, consider vertex v a 1x4 matrix: [v.x v.y v.z 1]
-	// Multiply it by the Qsum 4x4 matrix, resulting in a 1x4 matrix
+#pragma omp parallel for schedule(dynamic, 4096)
+	for (i = 0; i < nTris; ++i)
+	{
+		triangle& t = _newmesh.getTri(i);
+		t = _orderedMesh.getTri(i);
+		t.changeMesh(&_newmesh);
+		t.setActive(0 != (cp._activeTris[i / 32] & (1u << (i % 32))));
+	}
 
-	double result[4];
+	const int nChangedTris = (int) cp._changedTris.size() / 4;
+#pragma omp parallel for schedule(dynamic, 4096)
+	for (i = 0; i < nChangedTris; ++i)
+	{
+		const int* pt = &cp._changedTris[4 * i];
+		_newmesh.getTri(pt[0]).setVerts(pt[1], pt[2], pt[3]);
+	}
 
-	const Vec3 v3 = v.getXYZ();
+	// A triangle's normal changes if it has other vertices, or if one of
+	// its vertices has moved
+#pragma omp parallel for schedule(dynamic, 4096)
+	for (i = 0; i < nTris; ++i)
+	{
+		triangle& t = _newmesh.getTri(i);
+		if (t.isActive()) t.calcNormal();
+	}
 
-	result[0] = v3.x * Qsum[0][0] + v3.y * Qsum[1][0] +
-				v3.z * Qsum[2][0] + 1 * Qsum[3][0];
-	result[1] = v3.x * Qsum[0][1] + v3.y * Qsum[1][1] +
-				v3.z * Qsum[2][1] + 1 * Qsum[3][1];
-	result[2] = v3.x * Qsum[0][2] + v3.y * Qsum[1][2] +
-				v3.z * Qsum[2][2] + 1 * Qsum[3][2];
-	result[3] = v3.x * Qsum[0][3] + v3.y * Qsum[1][3] +
-				v3.z * Qsum[2][3] + 1 * Qsum[3][3];
+	corners = _orderedMesh.getCorners();
+	for (i = 0; i < (int) cp._changedCorners.size(); i += 2)
+	{
+		corners.setOpposite(cp._changedCorners[i], cp._changedCorners[i + 1]);
+	}
 
-	// Multiply this 1 x 4 matrix by the vertex v transpose (a 4 x 1 matrix).
-	// This is just the dot product.
+	// Each changed triangle is a neighbor of its new vertices too (see
+	// applyCollapse())
+	_newmesh.copyTriNeighbors(_orderedMesh);
+	for (i = 0; i < nChangedTris; ++i)
+	{
+		const int* pt = &cp._changedTris[4 * i];
+		for (int k = 1; k <= 3; ++k)
+		{
+			_newmesh.addTriNeighbor(pt[k], pt[0]);
+		}
+	}
 
-	cost =	result[0] * v3.x + result[1] * v3.y +
-			result[2] * v3.z + result[3] * 1; 
+	_nextCollapse = cp._nCollapses;
+	_nVisTriangles = _visTris[cp._nCollapses];
+	_bViewRefined = false;
+	++_meshVersion;
 
-	if (QUADRICTRI == _cost && triArea != 0)
+	// Every triangle may have changed, & the visible ones are back in
+	// their own slots
+#pragma omp parallel for schedule(dynamic, 4096)
+	for (i = 0; i < nTris; ++i)
 	{
-		cost /= triArea;
+		_newmesh.getTri(i).getVerts(_indices[3 * i], _indices[3 * i + 1], _indices[3 * i + 2]);
+		_triSlots[i] = (i < _nVisTriangles) ? i : -1;
+		_slotTris[i] = i;
 	}
+	_dirtyRanges.clear();
+	addDirtyRange(0, nTris);
 
-	return cost;
+	_affectedVerts.resize(nVerts);
+	for (i = 0; i < nVerts; ++i) _affectedVerts[i] = i;
+	calcVertNormals(_affectedVerts);
+	_affectedVerts.clear();
 }
 
 // Collapse an edge (remove one vertex & edge, and possibly some triangles.)
-bool PMesh::collapseEdge()
+// The triangle neighbors of the "to vertex" are kept up to date, so a
+// vertex normal adds up the triangles which use the vertex now.  (The
+// hidden triangles stay neighbors, & so do the "from vertex"'s, since
+// it isn't used until the collapse is undone.)
+void PMesh::applyCollapse(int n, vector<int> &affectedVerts)
 {
-	// Iterator always points to next collapse to perform
-	if (_edgeCollapseIter == _edgeCollList.end()) return false; // no more edge collapses in list
-	EdgeCollapse& ec = *_edgeCollapseIter;
+	const CollapseRecord& ec = _history[n];
+	const AdjacencyRow trisRemoved = _history.trisRemoved(n);
+	const AdjacencyRow trisAffected = _history.trisAffected(n);
 
-	set<int> affectedVerts; // vertices affected by this edge collapse
 	int v1, v2, v3; // vertex indices
 
 	// Remove triangles 
-	set<int>::iterator tripos;
-	for (tripos = ec._trisRemoved.begin(); tripos != ec._trisRemoved.end(); ++tripos) 
+	const int* tripos;
+	for (tripos = trisRemoved.begin(); tripos != trisRemoved.end(); ++tripos) 
 	{
 		// get triangle
 		int triIndex = *tripos;
 		triangle& t = _newmesh.getTri(triIndex);
 		t.getVerts(v1, v2, v3); // get triangle vertices
 		t.setActive(false);
-		affectedVerts.insert(v1); // add vertices to list
-		affectedVerts.insert(v2); // of vertices affected
-		affectedVerts.insert(v3); // by this collapse
+		_newmesh.getCorners().removeTri(_newmesh, triIndex, ec._vfrom, ec._vto);
+		affectedVerts.push_back(v1); // add vertices to list
+		affectedVerts.push_back(v2); // of vertices affected
+		affectedVerts.push_back(v3); // by this collapse
+	}
+
+	// Take them out of the index buffer, last first.  (When the edge
+	// collapses are done in order, they're the last visible triangles, so
+	// none of the others move.)
+	for (tripos = trisRemoved.end(); tripos != trisRemoved.begin(); )
+	{
+		removeIndices(*--tripos);
+	}
+
+	// Move the "to vertex", if it has a new position
+	if (_history.movesToVert(n))
+	{
+		_newmesh.getVertex(ec._vto).getXYZ() = _history.position(n);
+		updateMovedTriNormals(n, affectedVerts);
 	}
 
 	// Adjust vertices of triangles
-	for (tripos = ec._trisAffected.begin(); tripos != ec._trisAffected.end(); ++tripos) 
+	for (tripos = trisAffected.begin(); tripos != trisAffected.end(); ++tripos) 
 	{
 		// get triangle
 		int triIndex = *tripos;
 		triangle& t = _newmesh.getTri(triIndex);
 		t.changeVertex(ec._vfrom, ec._vto); // update the vertex of this triangle
 		t.calcNormal(); // reset the normal for the triangle
+		_newmesh.addTriNeighbor(ec._vto, triIndex);
+		updateIndices(triIndex);
 		t.getVerts(v1, v2, v3); // get triangle vertices
-		affectedVerts.insert(v1); // add vertices to list
-		affectedVerts.insert(v2); // of vertices affected
-		affectedVerts.insert(v3); // by this collapse
+		affectedVerts.push_back(v1); // add vertices to list
+		affectedVerts.push_back(v2); // of vertices affected
+		affectedVerts.push_back(v3); // by this collapse
 	}
 
-	// redo the vertex normal for the vertices affected.  these are
-	// vertices of triangles which were shifted around as a result
-	// of this edge collapse.
-	set<int>::iterator affectedVertsIter;
-	for (affectedVertsIter = affectedVerts.begin(); affectedVertsIter != affectedVerts.end(); ++affectedVertsIter) 
-	{
-		if (ec._vfrom == *affectedVertsIter) continue; // skip the from vertex -- it's no longer active
+	++_meshVersion;
+}
 
-		// We have the affected vertex index, so redo the its normal (for Gouraud shading);
-		_newmesh.calcOneVertNormal(*affectedVertsIter);
+// Reset the normals of the triangles which changed shape because the
+// "to vertex" of an edge collapse moved, & add their vertices to the
+// vertices which need new normals.
+void PMesh::updateMovedTriNormals(int nCollapse, vector<int> &affectedVerts)
+{
+	const AdjacencyRow trisMoved = _history.trisMoved(nCollapse);
+	const int* tripos;
+	for (tripos = trisMoved.begin(); tripos != trisMoved.end(); ++tripos) 
+	{
+		triangle& t = _newmesh.getTri(*tripos);
+		t.calcNormal();
+		affectedVerts.push_back(t.getVert1Index());
+		affectedVerts.push_back(t.getVert2Index());
+		affectedVerts.push_back(t.getVert3Index());
 	}
-
-	// Since iterator always points to next collapse to perform, go to the next
-	// collapse in list.
-	++_edgeCollapseIter;
-
-	_nVisTriangles -=  ec._trisRemoved.size();
-
-	return true;
 }
 
 // Split a vertex (add one vertex & edge, and possibly some triangles.)
-bool PMesh::splitVertex()
+void PMesh::undoCollapse(int n, vector<int> &affectedVerts)
 {
-	// Iterator always points to next collapse to perform.
-	// But we don't want to collapse, we want to undo the previous
-	// collapse.  Go to that edge collapse, unless we're at the front of
-	// the list, in which case there are no collapses to undo (the mesh
-	// is fully displayed w/o any collapses).
-	if (_edgeCollapseIter == _edgeCollList.begin()) return false;
-	--_edgeCollapseIter; // go to previous edge collapse, so we can undo it
-	EdgeCollapse& ec = *_edgeCollapseIter;
-
-	set<int> affectedVerts; // vertices affected by this edge collapse
+	const CollapseRecord& ec = _history[n];
+	const AdjacencyRow trisRemoved = _history.trisRemoved(n);
+	const AdjacencyRow trisAffected = _history.trisAffected(n);
+
 	int v1, v2, v3; // vertex indices
 
-	// Add triangles which were removed
-	set<int>::iterator tripos;
-	for (tripos = ec._trisRemoved.begin(); tripos != ec._trisRemoved.end(); ++tripos) 
+	// Put the "to vertex" back where it was
+	if (_history.movesToVert(n))
+	{
+		_newmesh.getVertex(ec._vto).getXYZ() = _history.oldPosition(n);
+		updateMovedTriNormals(n, affectedVerts);
+	}
+
+	// Add triangles which were removed.  Their normals are reset, since
+	// a hidden triangle's normal isn't kept up to date.
+	const int* tripos;
+	for (tripos = trisRemoved.begin(); tripos != trisRemoved.end(); ++tripos) 
 	{
 		// get triangle
 		int triIndex = *tripos;
 		triangle& t = _newmesh.getTri(triIndex);
 		t.setActive(true);
+		t.calcNormal();
+		_newmesh.getCorners().restoreTri(triIndex);
+		addIndices(triIndex);
 		t.getVerts(v1, v2, v3); // get triangle vertices
-		affectedVerts.insert(v1); // add vertices to list
-		affectedVerts.insert(v2); // of vertices affected
-		affectedVerts.insert(v3); // by this collapse
+		affectedVerts.push_back(v1); // add vertices to list
+		affectedVerts.push_back(v2); // of vertices affected
+		affectedVerts.push_back(v3); // by this collapse
 	}
 
 	// Adjust vertices of triangles
-	for (tripos = ec._trisAffected.begin(); tripos != ec._trisAffected.end(); ++tripos) 
+	for (tripos = trisAffected.begin(); tripos != trisAffected.end(); ++tripos) 
 	{
 		// get triangle
 		int triIndex = *tripos;
 		triangle& t = _newmesh.getTri(triIndex);
 		t.changeVertex(ec._vto, ec._vfrom); // update the vertex of this triangle
 		t.calcNormal(); // reset the normal for the triangle
+		_newmesh.removeTriNeighbor(ec._vto, triIndex);
+		_newmesh.addTriNeighbor(ec._vfrom, triIndex); // unless it's still there
+		updateIndices(triIndex);
 		t.getVerts(v1, v2, v3); // get triangle vertices
-		affectedVerts.insert(v1); // add vertices to list
-		affectedVerts.insert(v2); // of vertices affected
-		affectedVerts.insert(v3); // by this collapse
+		affectedVerts.push_back(v1); // add vertices to list
+		affectedVerts.push_back(v2); // of vertices affected
+		affectedVerts.push_back(v3); // by this collapse
 	}
+	affectedVerts.push_back(ec._vto); // it has fewer triangles now
 
-	// redo the vertex normal for the vertices affected.  these are
-	// vertices of triangles which were shifted around as a result
-	// of this edge split.
-	set<int>::iterator affectedVertsIter;
-	for (affectedVertsIter = affectedVerts.begin(); affectedVertsIter != affectedVerts.end(); ++affectedVertsIter) 
+	++_meshVersion;
+}
+
+void PMesh::updateIndices(int t)
+{
+	const int s = _triSlots[t];
+	_newmesh.getTri(t).getVerts(_indices[3 * s], _indices[3 * s + 1], _indices[3 * s + 2]);
+	addDirtyRange(s, s + 1);
+}
+
+// The visible triangles are the first _nVisTriangles slots, so a triangle
+// which is added back goes in the next one
+void PMesh::addIndices(int t)
+{
+	const int s = _nVisTriangles++;
+	_triSlots[t] = s;
+	_slotTris[s] = t;
+	updateIndices(t);
+}
+
+// Move the last visible triangle into the slot of the one which is removed
+void PMesh::removeIndices(int t)
+{
+	const int s = _triSlots[t];
+	const int last = --_nVisTriangles;
+	_triSlots[t] = -1;
+	if (s == last) return;
+
+	const int moved = _slotTris[last];
+	_triSlots[moved] = s;
+	_slotTris[s] = moved;
+	for (int k = 0; k < 3; ++k)
+	{
+		_indices[3 * s + k] = _indices[3 * last + k];
+	}
+	addDirtyRange(s, s + 1);
+}
+
+// A range which overlaps or touches the last one is merged w/ it.  The
+// triangles changed by an edge collapse are sorted, so neighbors in the
+// index buffer end up in the same range.
+void PMesh::addDirtyRange(int first, int last)
+{
+	const int nRanges = (int) _dirtyRanges.size() / 2;
+	if (nRanges > 0)
+	{
+		int &prevFirst = _dirtyRanges[2 * nRanges - 2];
+		int &prevLast = _dirtyRanges[2 * nRanges - 1];
+		if (first <= prevLast && last >= prevFirst)
+		{
+			prevFirst = min(prevFirst, first);
+			prevLast = max(prevLast, last);
+			return;
+		}
+	}
+
+	// Too many ranges cost more to upload one by one than the triangles
+	// in between, so replace them w/ one range which covers them all
+	if (nRanges >= MAX_DIRTY_RANGES)
+	{
+		for (int i = 0; i < nRanges; ++i)
+		{
+			first = min(first, _dirtyRanges[2 * i]);
+			last = max(last, _dirtyRanges[2 * i + 1]);
+		}
+		_dirtyRanges.clear();
+	}
+
+	_dirtyRanges.push_back(first);
+	_dirtyRanges.push_back(last);
+}
+
+// Each vertex normal only depends on the normals of its own triangles,
+// so they're independent.  (Only big jumps are worth the threads.)
+void PMesh::calcVertNormals(const vector<int> &verts)
+{
+	const int nVerts = (int) verts.size();
+	int i;
+#pragma omp parallel for schedule(dynamic, 1024) if (nVerts > 4096)
+	for (i = 0; i < nVerts; ++i)
 	{
 		// We have the affected vertex index, so redo the its normal (for Gouraud shading);
-		_newmesh.calcOneVertNormal(*affectedVertsIter);
+		_newmesh.calcOneVertNormal(verts[i]);
 	}
+}
 
-	_nVisTriangles +=  ec._trisRemoved.size();
-	
-	// Since iterator always points to next collapse to perform, leave it here.
+// _meshVersion changes whenever an edge collapse is done or undone, so
+// that's all which is checked.
+const float* PMesh::getSmoothVertexArray()
+{
+	if (_smoothVertsVersion != _meshVersion)
+	{
+		const int nVerts = _newmesh.getNumVerts();
+		const Vec3* positions = _newmesh.getVertexArrays().getPositions();
+		const Vec3* normals = _newmesh.getVertexArrays().getNormals();
+		_smoothVerts.resize(6 * (size_t) nVerts);
+
+		int i;
+#pragma omp parallel for if (nVerts > 65536)
+		for (i = 0; i < nVerts; ++i)
+		{
+			float* p = &_smoothVerts[6 * (size_t) i];
+			p[0] = normals[i].x; p[1] = normals[i].y; p[2] = normals[i].z;
+			p[3] = positions[i].x; p[4] = positions[i].y; p[5] = positions[i].z;
+		}
+
+#ifndef NDEBUG
+		// The vertex normals should match the visible triangles
+		assertVertNormalsMatch(_newmesh);
+#endif
+		_smoothVertsVersion = _meshVersion;
+	}
+	return _smoothVerts.empty() ? 0 : &_smoothVerts[0];
+}
+
+const float* PMesh::getFlatVertexArray()
+{
+	if (_flatVertsVersion != _meshVersion)
+	{
+		const Vec3* positions = _newmesh.getVertexArrays().getPositions();
+		_flatVerts.resize(18 * (size_t) _nVisTriangles);
+
+		int i;
+#pragma omp parallel for if (_nVisTriangles > 32768)
+		for (i = 0; i < _nVisTriangles; ++i)
+		{
+			const triangle& t = _newmesh.getTri(_slotTris[i]);
+			const Vec3& n = t.getNormalVec3();
+			float* p = &_flatVerts[18 * (size_t) i];
+			for (int k = 0; k < 3; ++k, p += 6)
+			{
+				const Vec3& pos = positions[t.getVertIndex(k)];
+				p[0] = n.x; p[1] = n.y; p[2] = n.z;
+				p[3] = pos.x; p[4] = pos.y; p[5] = pos.z;
+			}
+		}
+
+#ifndef NDEBUG
+		// Each face's normal should match the positions it's drawn w/
+		for (i = 0; i < _nVisTriangles; ++i)
+		{
+			const float* p = &_flatVerts[18 * (size_t) i];
+			const Vec3 p1(p[3], p[4], p[5]), p2(p[9], p[10], p[11]), p3(p[15], p[16], p[17]);
+			Vec3 d = (p2 - p1).unitcross(p3 - p2) - Vec3(p[0], p[1], p[2]);
+			assert(d.dot(d) < 1e-6f);
+		}
+#endif
+		_flatVertsVersion = _meshVersion;
+	}
+	return _flatVerts.empty() ? 0 : &_flatVerts[0];
+}
+
+// Visit the vertices which haven't been collapsed, round robin.  A
+// vertex is split while the last collapse into it needs more detail, or
+// else it's collapsed, if its own collapse doesn't need the detail & the
+// collapses it depends on have been done.  The vertex normals are
+// recalculated once at the end, like setCollapseIndex().
+int PMesh::refineForView(const ViewParams& view, double maxSeconds)
+{
+	const int nVerts = _newmesh.getNumVerts();
+	int v;
+	if (_history.empty() || 0 == nVerts) return 0;
+
+	if (_hierarchy.empty())
+	{
+		_hierarchy.build(_history, _orderedMesh);
+	}
+
+	// Start from the first _nextCollapse edge collapses
+	if (!_bViewRefined)
+	{
+		_bCollapseDone.resize(_history.size());
+		for (int n = 0; n < _history.size(); ++n)
+		{
+			_bCollapseDone[n] = (n < _nextCollapse);
+		}
+		_nMergesDone.resize(nVerts);
+		for (v = 0; v < nVerts; ++v)
+		{
+			const AdjacencyRow merges = _hierarchy.merges(v);
+			_nMergesDone[v] = (int) (lower_bound(merges.begin(), merges.end(), _nextCollapse) - merges.begin());
+		}
+		_bViewRefined = true;
+	}
+
+	const clock_t start = clock();
+	const double maxClocks = maxSeconds * CLOCKS_PER_SEC;
+	int nChanges = 0;
+	_affectedVerts.clear();
+
+	for (int nVisited = 0; nVisited < nVerts; ++nVisited)
+	{
+		// Checking the clock costs more than checking a vertex
+		if (nVisited > 0 && 0 == nVisited % 128 && clock() - start > maxClocks) break;
+
+		v = _nextRefineVert;
+		if (++_nextRefineVert == nVerts) _nextRefineVert = 0;
+
+		const int r = _hierarchy.removedBy(v);
+		if (r >= 0 && _bCollapseDone[r]) continue; // it's been collapsed
+
+		const AdjacencyRow merges = _hierarchy.merges(v);
+		bool bSplit = false;
+		while (_nMergesDone[v] > 0)
+		{
+			const int n = merges.begin()[_nMergesDone[v] - 1];
+			if (!_hierarchy.needsDetail(n, view)) break;
+			nChanges += undoWithDependents(n);
+			bSplit = true;
+		}
+
+		if (!bSplit && r >= 0 && canCollapse(r) && !_hierarchy.needsDetail(r, view))
+		{
+			collapseForView(r);
+			++nChanges;
+		}
+	}
+
+	// Skip the vertices which were collapsed
+	vector<int> &affectedVerts = _affectedVerts;
+	sort(affectedVerts.begin(), affectedVerts.end());
+	affectedVerts.erase(unique(affectedVerts.begin(), affectedVerts.end()), affectedVerts.end());
+	int nAffected = 0;
+	for (int i = 0; i < (int) affectedVerts.size(); ++i)
+	{
+		const int r = _hierarchy.removedBy(affectedVerts[i]);
+		if (r < 0 || !_bCollapseDone[r]) affectedVerts[nAffected++] = affectedVerts[i];
+	}
+	affectedVerts.resize(nAffected);
+	calcVertNormals(affectedVerts);
+
+#ifndef NDEBUG
+	assertTriNormalsMatch(_newmesh);
+	assertVertNormalsMatch(_newmesh);
+#endif
+
+	return nChanges;
+}
+
+bool PMesh::canCollapse(int n) const
+{
+	const AdjacencyRow dependencies = _hierarchy.dependencies(n);
+	for (const int* pos = dependencies.begin(); pos != dependencies.end(); ++pos)
+	{
+		if (!_bCollapseDone[*pos]) return false;
+	}
 	return true;
 }
 
+void PMesh::collapseForView(int n)
+{
+	applyCollapse(n, _affectedVerts);
+	_bCollapseDone[n] = true;
+	++_nMergesDone[_history[n]._vto];
+	++_nextCollapse;
+	if (_history.movesToVert(n)) updateVertTriNormals(_history[n]._vto, _affectedVerts);
+}
+
+void PMesh::splitForView(int n)
+{
+	undoCollapse(n, _affectedVerts);
+	_bCollapseDone[n] = false;
+	--_nMergesDone[_history[n]._vto];
+	--_nextCollapse;
+	if (_history.movesToVert(n)) updateVertTriNormals(_history[n]._vto, _affectedVerts);
+}
+
+// When a vertex moves, the edge collapse only resets the normals of the
+// triangles which were visible when the list was built.  W/ the
+// collapses done out of order, others can be visible too, so every
+// visible triangle which uses the vertex is reset.
+void PMesh::updateVertTriNormals(int v, vector<int> &affectedVerts)
+{
+	const AdjacencyRow tris = _newmesh.getTriNeighbors(v);
+	for (const int* tripos = tris.begin(); tripos != tris.end(); ++tripos)
+	{
+		triangle& t = _newmesh.getTri(*tripos);
+		if (!t.isActive()) continue;
+		t.calcNormal();
+		affectedVerts.push_back(t.getVert1Index());
+		affectedVerts.push_back(t.getVert2Index());
+		affectedVerts.push_back(t.getVert3Index());
+	}
+}
+
+// The dependents are found depth first, w/ a stack instead of recursion.
+// They always come later in the list of edge collapses, so a collapse
+// can't be on the stack twice.
+int PMesh::undoWithDependents(int n)
+{
+	vector<int> &stack = _undoStack;
+	int nUndone = 0;
+
+	stack.push_back(n);
+	while (!stack.empty())
+	{
+		const int m = stack.back();
+		const AdjacencyRow dependents = _hierarchy.dependents(m);
+		const int* pos;
+		for (pos = dependents.begin(); pos != dependents.end() && !_bCollapseDone[*pos]; ++pos) {}
+
+		if (pos != dependents.end())
+		{
+			stack.push_back(*pos);
+		}
+		else
+		{
+			splitForView(m);
+			stack.pop_back();
+			++nUndone;
+		}
+	}
+	return nUndone;
+}
+
 // Return a short text description of the current Edge Cost method
 char* PMesh::getEdgeCostDesc()
 {
@@ -17,61 +17,82 @@
 //using namespace std;
 
 #include <vector>
-#include <list>
+#include <algorithm>
+#include <float.h>
+#include <limits.h>
 #include "vertex.h"
 #include "triangle.h"
 #include "mesh.h"
+#include "adjacency.h"
+#include "costheap.h"
+#include "collapsehistory.h"
+#include "vertexhierarchy.h"
 using namespace std;
 
 
-// The edge collapse structure.  The "from vertex" will
-// be collapsed to the "to vertex."  This may flatten some
-// triangles, which will be removed, and will affect those
-// triangles which contain the "from vertex".  Those triangles
-// will be updated with the new vertex.
-struct EdgeCollapse
+// The edges of the mesh, used by the quadric edge collapse methods.
+// Both ways of collapsing an edge use the same summed quadric, so each
+// edge is in the heap once, w/ the cost of its cheaper direction.
+struct QuadricEdges
 {
-	int _vfrom;
-	int _vto;
-	set<int> _trisRemoved;
-	set<int> _trisAffected;
-
-
-	// Used for debugging
-	void dumpEdgeCollapse()
-	{
-		std::cout << "**** Edge Collapse Dump ****" << std::endl;
-
-		std::cout << "\tFrom Vert# " << _vfrom << " to Vert# " << _vto << std::endl;
-		cout << "\tTris removed:";
-		set<int>::iterator pos;
-		for (pos = _trisRemoved.begin(); pos != _trisRemoved.end(); ++pos) 
-		{
-			std::cout << " " << *pos;
-		}
-		cout << std::endl << "\tTris affected:";
-		for (pos = _trisAffected.begin(); pos != _trisAffected.end(); ++pos) 
-		{
-			std::cout << " " << *pos;
-		}
-		std::cout  << std::endl << "**** End of Edge Collapse Dump ****" << std::endl;
-	}
+	vector<int> _verts; // 2 per edge:  its cheaper collapse is _verts[2e] to _verts[2e + 1]
+	MutableAdjacency _vertEdges; // edges which use each vertex
+	CostHeap _heap; // edges, ordered by collapse cost
 };
 
-// This is a "pointer" to a vertex in a given mesh
-struct vertexPtr
+
+// How far to simplify the mesh.  Building the list of edge collapses
+// stops at the first limit reached, so it only costs as much as the
+// lowest level of detail which is needed.  By default there's no
+// limit, and the mesh is collapsed as far as it will go.
+struct CollapseLimits
 {
-	Mesh* _meshptr;
-	int _index; // ptr to vertex position in mesh
+	int _minTris; // stop when this many triangles (or fewer) are visible, if > 0
+	double _maxCost; // stop before collapsing an edge which costs more than this
+	int _maxCollapses; // stop after this many edge collapses
 
-	bool operator<(const vertexPtr& vp) const 
-	{
-		return (_meshptr->getVertex(_index) < vp._meshptr->getVertex(vp._index));
-	}
+	CollapseLimits() : _minTris(0), _maxCost(DBL_MAX), _maxCollapses(INT_MAX) {};
 };
 
 
-typedef multiset<vertexPtr, less<vertexPtr> > vertexPtrSet;
+// A batch of edge collapses which are done at the same time, when the
+// list of edge collapses is built in parallel.  The collapses in a batch
+// don't share any vertices of the triangles around their "from" & "to"
+// vertices, so each one changes a separate part of the mesh.
+struct CollapseBatch
+{
+	// The cheapest vertices (or edges) in the heap, from which the batch
+	// is picked
+	vector<int> _candidates; // vertex or edge # in the heap
+	vector<double> _candidateCosts;
+	vector<EdgeCollapse> _candidateCollapses;
+	vector<char> _bBadCandidate; // can't be collapsed (see insureEdgeCollapseValid)
+	vector< vector<int> > _candidateVerts; // vertices of the triangles around each one
+	vector<int> _nCandidateTrisRemoved; // # of triangles w/ both vertices
+
+	vector<EdgeCollapse> _collapses;
+	vector<double> _costs; // cost of each collapse, when it was picked
+	vector< vector<int> > _affectedVerts; // vertices of the triangles changed by each collapse (sorted)
+	vector< vector<int> > _removedEdges; // edges removed by each collapse (quadric methods)
+
+	vector<int> _round; // last round in which each vertex was used by a collapse
+	int _nRound; // # of the current round
+};
+
+// Scratch space for building the list of edge collapses, which is kept
+// from one collapse to the next, so the loop doesn't allocate memory
+// once the vectors have grown.  Each thread has its own.
+struct CollapseScratch
+{
+	vector<int> _triNeighbors; // copy of the "from vertex"'s triangles (see updateTriangles)
+	vector<int> _affectedVerts; // vertices of the triangles changed by a collapse (sorted)
+	vector<int> _removedEdges; // edges removed by a collapse (quadric methods)
+
+	// used by melaxCollapseCost()
+	vector<CornerTable::RingEdge> _ring;
+	vector<Vec3> _faceNormals;
+	vector<Vec3> _edgeNormals;
+};
 
 
 // Progressive Mesh class.  This class will calculate and keep track
@@ -83,7 +104,20 @@ public:
 	// Type of progress mesh algorithm
 	enum EdgeCost {SHORTEST, MELAX, QUADRIC, QUADRICTRI, MAX_EDGECOST};
 
-	PMesh(Mesh* mesh, EdgeCost ec);
+	// Where the "to vertex" of an edge collapse ends up.  By default it
+	// stays where it is.  The quadric methods can instead move it to the
+	// point which has the smallest quadric error (Garland & Heckbert's
+	// optimal placement), which keeps the simplified mesh closer to the
+	// original.  If that point can't be found, the midpoint of the edge
+	// or the "to vertex" is used, whichever has the smaller error.  The
+	// other methods ignore this.
+	enum Placement {PLACE_ENDPOINT, PLACE_OPTIMAL, MAX_PLACEMENT};
+
+	// If bParallel is true, the list of edge collapses is built in
+	// parallel, from batches of edge collapses which don't overlap.  The
+	// list is a little different from the one built serially.
+	PMesh(Mesh* mesh, EdgeCost ec, const CollapseLimits& limits = CollapseLimits(),
+		  bool bParallel = false, Placement placement = PLACE_ENDPOINT);
 
 	// Collapse one vertex to another.
 	bool collapseEdge();
@@ -92,14 +126,108 @@ public:
 	// is the opposite of a collapse
 	bool splitVertex();
 
+	// Go straight to the level of detail after the first k edge collapses,
+	// doing (or undoing) all the collapses in between at once.  The vertex
+	// normals are recalculated once at the end, in parallel.  If k is past
+	// either end of the list, it goes as far as it can & returns false.
+	bool setCollapseIndex(int k);
+	int getCollapseIndex() const {return _nextCollapse;}
+
+	// Go to the most detailed level w/ at most n visible triangles (or as
+	// close as the list of edge collapses gets).  Returns false if there
+	// are still more than n.
+	bool setVisibleTriangleCount(int n);
+
+	// Save the state of the mesh every nInterval edge collapses, so 
+	// setCollapseIndex() can start from the nearest checkpoint, & replay
+	// at most nInterval / 2 collapses, instead of replaying every one in
+	// between.  A longer interval takes less memory.  0 (the default)
+	// keeps no checkpoints.
+	void setCheckpointInterval(int nInterval);
+	int getCheckpointInterval() const {return _checkpointInterval;}
+
+	// Memory used by the checkpoints, & by the list of edge collapses
+	// (including the # of visible triangles after each one)
+	size_t checkpointBytes() const;
+	size_t historyBytes() const {return _history.bytesUsed() + _visTris.size() * sizeof(int);}
+
 	// number of edge collapses
-	int numCollapses() {return _edgeCollList.size();}
-	int numEdgeCollapses() {return _edgeCollList.size();}
+	int numCollapses() {return _history.size();}
+	int numEdgeCollapses() {return _history.size();}
 
 	// number of triangles, and visible triangles in mesh
 	int numTris() {return _newmesh.getNumTriangles();}
 	int numVisTris() {return _nVisTriangles;}
 
+	// Once the list of edge collapses is built, the vertices & triangles
+	// are renumbered in the reverse of the order they're collapsed, so
+	// after any # of edge collapses, the visible triangles are triangles
+	// 0 ... numVisTris() - 1, & the vertices which haven't been collapsed
+	// are vertices 0 ... numVisVerts() - 1.  Each level of detail can be
+	// drawn from the start of the arrays, w/o checking which triangles
+	// are active.  (A triangle which uses a vertex twice only has one of
+	// them changed by an edge collapse, so it may still use a vertex
+	// which has been collapsed.)  This only holds while the edge
+	// collapses are done in order, i.e. not after refineForView().
+	int numVerts() {return _newmesh.getNumVerts();}
+	int numVisVerts() {return _newmesh.getNumVerts() - _nextCollapse;}
+
+	// # of a vertex or triangle in the mesh passed to the constructor
+	int getOriginalVert(int v) const {return _vertOrder[v];}
+	int getOriginalTri(int t) const {return _triOrder[t];}
+
+	// The vertices of the visible triangles, packed 3 per triangle.  While
+	// the edge collapses are done in order, triangle i is indices 3i,
+	// 3i + 1 & 3i + 2.  The buffer is kept up to date as edges are
+	// collapsed & vertices split, so a copy of it (e.g. in an OpenGL
+	// buffer) only needs the ranges logged below.
+	const int* getIndices() const {return _indices.empty() ? 0 : &_indices[0];}
+	int numIndices() {return 3 * _nVisTriangles;}
+
+	// Ranges of triangles, first ... last - 1, whose indices have changed
+	// since clearDirtyRanges(), or which have been added back by splitting
+	// vertices.  A removed triangle is replaced by the last visible one,
+	// so numIndices() covers the rest.  (When the edge collapses are done
+	// in order, it's always the last one.)  Too many ranges are merged
+	// into one.
+	int numDirtyRanges() const {return (int) _dirtyRanges.size() / 2;}
+	void getDirtyRange(int i, int &first, int &last) const {first = _dirtyRanges[2 * i]; last = _dirtyRanges[2 * i + 1];}
+	void clearDirtyRanges() {_dirtyRanges.clear();}
+
+	// Vertex arrays for drawing the current level of detail, w/ a normal
+	// then a position (6 floats) per vertex, i.e. OpenGL's GL_N3F_V3F
+	// interleaved format.  Each one is built when it's asked for, & then
+	// kept until the mesh changes.
+	//
+	// For smooth shading, every vertex w/ its vertex normal (the sum of
+	// the normals of the visible triangles which use it, normalized),
+	// drawn w/ the numIndices() indices of getIndices().  For flat
+	// shading, the 3 vertices of each visible triangle in turn, w/ the
+	// triangle's normal (3 * numVisTris() vertices, drawn w/o indices).
+	const float* getSmoothVertexArray();
+	const float* getFlatVertexArray();
+
+	// View-dependent refinement.  Instead of one level of detail for the
+	// whole mesh, vertices are split where the view needs more detail, &
+	// edges are collapsed where it doesn't (see VertexHierarchy), so the
+	// parts of the mesh near the camera get more triangles than the parts
+	// far away or outside the view frustum.  The edge collapses aren't
+	// done in order, so getCollapseIndex() is just the # which are done.
+	//
+	// Each call visits the vertices which haven't been collapsed,
+	// starting where the last call stopped, until it's been around all of
+	// them or maxSeconds is up, & returns the # of edge collapses & vertex
+	// splits done.  (The vertex normals are recalculated after that.)
+	// Calling it every frame refines the mesh a bit at a time as the view
+	// changes.  setCollapseIndex() (& the other ways of
+	// setting the level of detail) go back to a single level of detail.
+	int refineForView(const ViewParams& view, double maxSeconds);
+	bool isViewRefined() const {return _bViewRefined;}
+
+	// Memory used by the vertex hierarchy, which is built the first time
+	// refineForView() is called
+	size_t hierarchyBytes() const {return _hierarchy.bytesUsed();}
+
 	bool getTri(int i, triangle& t) {
 		t = _newmesh.getTri(i);
 		return true;
@@ -111,31 +239,104 @@ public:
 private:
 
 	Mesh* _mesh; // original mesh - not changed
+	Mesh _orderedMesh; // original mesh, renumbered in collapse order
 	Mesh _newmesh; // we change this one
 
-	EdgeCost _cost; // Type of progressive mesh algorithm
+	vector<int> _vertOrder; // original # of each vertex of _orderedMesh
+	vector<int> _triOrder; // original # of each triangle of _orderedMesh
 
-	list<EdgeCollapse> _edgeCollList; // list of edge collapses
-	list<EdgeCollapse>::iterator _edgeCollapseIter;
+	EdgeCost _cost; // Type of progressive mesh algorithm
+	CollapseLimits _limits; // when to stop collapsing edges
+	bool _bParallel; // build the list of edge collapses in batches, in parallel
+	Placement _placement; // where the "to vertex" of each edge collapse goes
+
+	CollapseHistory _history; // list of edge collapses
+	int _nextCollapse; // the next edge collapse to do (the ones before it are done), or the # done after refineForView()
+
+	// used by setCollapseIndex(), & kept so stepping one collapse at a 
+	// time doesn't allocate memory
+	vector<int> _affectedVerts; // vertices which need new normals
+	vector<int> _removedVerts; // "from vertices" which were collapsed
+
+	vector<int> _visTris; // # of visible triangles after each # of edge collapses
+
+	vector<int> _indices; // vertices of each visible triangle (see getIndices())
+	vector<int> _triSlots; // where each triangle is in _indices, or -1 if it's not visible
+	vector<int> _slotTris; // the triangle in each slot of _indices
+	vector<int> _dirtyRanges; // 2 per range:  first triangle & one past the last
+	enum {MAX_DIRTY_RANGES = 1024};
+
+	vector<float> _smoothVerts; // see getSmoothVertexArray()
+	vector<float> _flatVerts; // see getFlatVertexArray()
+	int _meshVersion; // goes up each time the mesh changes
+	int _smoothVertsVersion; // _meshVersion they were built for, or -1
+	int _flatVertsVersion;
+	vector<CollapseCheckpoint> _checkpoints; // state after every _checkpointInterval collapses
+	int _checkpointInterval;
+
+	// View-dependent refinement.  The corner table can't follow edge
+	// collapses which aren't undone in reverse order, so setCollapseIndex()
+	// starts over from a checkpoint (or the original mesh) after it.
+	VertexHierarchy _hierarchy;
+	bool _bViewRefined; // some edge collapses have been done out of order
+	vector<char> _bCollapseDone; // is each edge collapse done?
+	vector<int> _nMergesDone; // # of the merges into each vertex which are done
+	vector<int> _undoStack; // used by undoWithDependents()
+	int _nextRefineVert; // where the next refineForView() starts
 
 	// functions used to calculate edge collapse costs.  Different
 	// methods can be used, depending on user preference.
-	double shortEdgeCollapseCost(Mesh& m, vertex& v);
-	double melaxCollapseCost(Mesh& m, vertex& v);
-	double quadricCollapseCost(Mesh& m, vertex& v);
+	double shortEdgeCollapseCost(Mesh& m, vertex v);
+	double melaxCollapseCost(Mesh& m, vertex v, CollapseScratch &scratch);
+
+	// Cost policies, one for each EdgeCost.  The functions which build
+	// the list of edge collapses are templates over a policy, so its
+	// cost functions are inlined into them, & the EdgeCost isn't checked
+	// for each vertex or edge.  The Shortest & Melax policies give the
+	// cost of a vertex (& set its "to vertex"); the quadric ones tell
+	// whether the quadrics are weighted by triangle area.
+	struct ShortestCost
+	{
+		static double vertCost(PMesh& pm, Mesh& m, vertex v, CollapseScratch&) {return pm.shortEdgeCollapseCost(m, v);}
+	};
+	struct MelaxCost
+	{
+		static double vertCost(PMesh& pm, Mesh& m, vertex v, CollapseScratch& scratch) {return pm.melaxCollapseCost(m, v, scratch);}
+	};
+	struct QuadricCost
+	{
+		enum {TRI_AREA = false};
+	};
+	struct QuadricTriCost
+	{
+		enum {TRI_AREA = true};
+	};
 
 	int _nVisTriangles; // # of triangles, after we collapse edges
 
 	// Create the list of the edge collapses used
-	// to simplify the mesh.
+	// to simplify the mesh.  It picks the cost policy from _cost, &
+	// builds the list from a heap of vertices or of edges.
 	void createEdgeCollapseList();
+	template <class Cost> void createVertCollapseList(int nVisTris);
+	template <class Cost> void createQuadricCollapseList(int nVisTris);
+
+	// Renumber the vertices & triangles of the original mesh & of the
+	// list of edge collapses, so each level of detail is a prefix of
+	// the vertices & of the triangles (see numVisVerts())
+	void renumberInCollapseOrder();
+
+	// Has the list of edge collapses reached one of the limits?  cost is
+	// the cost of the next collapse.
+	bool limitReached(double cost, int nCollapses, int nVisTris) const;
 
 	// Used in the QEM edge collapse methods.
 	void calcAllQMatrices(Mesh& mesh, bool bUseTriArea); // used for quadric method
-	double calcQuadricError(double Qsum[4][4], vertex& v, double triArea); // used for quadric method
+	template <class Cost> double calcQuadricError(const Quadric& Qsum, const Vec3& v3, double triArea); // used for quadric method
 
 	enum {BOUNDARY_WEIGHT = 1000}; // used to weight border edges so they don't collapse
-	void applyBorderPenalties(set<border> &borderSet, Mesh &mesh);
+	enum {EDGE_SLACK = 4}; // spare slots in each vertex's row of edges
+	void applyBorderPenalties(const vector<border> &borderEdges, Mesh &mesh);
 
 	PMesh(const PMesh&); // don't allow copy ctor -- too expensive
 	PMesh& operator=(const PMesh&); // don't allow assignment op.
@@ -144,72 +345,147 @@ private:
 #ifndef NDEBUG
 	// used in debugging
 	void assertEveryVertActive(int nVerts, int nTri, Mesh &mesh);
+	void assertTriNormalsMatch(const Mesh &mesh);
+	void assertVertNormalsMatch(const Mesh &mesh);
 #endif
 	// helper function for edge collapse costs
-	void calcEdgeCollapseCosts(vertexPtrSet &vertSet, vector<vertexPtrSet::iterator> &vertSetVec, 
-								  int nVerts, Mesh &mesh, EdgeCost &cost);
-
-	// Calculate the QEM matrices used to computer edge
-	// collapse costs.
-	void calcQuadricMatrices(EdgeCost &cost, Mesh &mesh);
+	template <class Cost> void calcEdgeCollapseCosts(CostHeap &vertHeap, int nVerts, Mesh &mesh);
 
 	// We can't collapse Vertex1 to Vertex2 if Vertex2 is invalid.
 	// This can happen if Vertex2 was previously collapsed to a
 	// separate vertex.
-	void insureEdgeCollapseValid(EdgeCollapse &ec, vertex &vc, Mesh &mesh, 
-									const EdgeCost &cost, bool &bBadVertex);
+	template <class Cost> void insureEdgeCollapseValid(EdgeCollapse &ec, vertex vc, Mesh &mesh, 
+													   bool &bBadVertex, CollapseScratch &scratch);
 
 	// Calculate the QEM for the "to vertex" in the edge collapse.
-	void setToVertexQuadric(vertex &to, vertex &from, const EdgeCost &cost);
+	template <class Cost> void setToVertexQuadric(vertex to, vertex from);
+
+	// Move the "to vertex" to its new position, before the collapse
+	// changes its quadric.  After the triangles have been updated, find
+	// the ones which changed shape because the "to vertex" moved.
+	template <class Cost> void placeToVertex(EdgeCollapse &ec, Mesh &mesh);
+	void updateMovedTris(EdgeCollapse &ec, Mesh &mesh);
+
+	// Do or undo edge collapse n to the triangles of the mesh, & add the
+	// vertices which need new normals to affectedVerts (w/ repeats).  The
+	// vertex normals aren't changed.
+	void applyCollapse(int n, vector<int> &affectedVerts);
+	void undoCollapse(int n, vector<int> &affectedVerts);
+
+	// When the mesh is simplified or restored, reset the normals of the
+	// triangles which changed shape because the "to vertex" moved.
+	void updateMovedTriNormals(int nCollapse, vector<int> &affectedVerts);
+
+	// Copy the vertices of triangle t to the index buffer, add it at the
+	// end, or take it out, & log the change
+	void updateIndices(int t);
+	void addIndices(int t);
+	void removeIndices(int t);
+	void addDirtyRange(int first, int last);
+
+	// Recalculate the normals of these vertices, in parallel
+	void calcVertNormals(const vector<int> &verts);
+
+	// Save the state of the mesh in a checkpoint, or go back to it
+	void saveCheckpoint(CollapseCheckpoint &cp);
+	void restoreCheckpoint(const CollapseCheckpoint &cp);
+
+	// Do or undo one edge collapse for view-dependent refinement.  An
+	// edge collapse can't be undone until the ones which depend on it
+	// have been, so undoWithDependents() undoes those first, & returns
+	// the # undone.
+	bool canCollapse(int n) const;
+	void collapseForView(int n);
+	void splitForView(int n);
+	int undoWithDependents(int n);
+	void updateVertTriNormals(int v, vector<int> &affectedVerts);
 
 	// At this point, we have an edge collapse.  We're collapsing the "from vertex"
 	// to the "to vertex."  For all the surrounding triangles which use this edge, 
 	// update "from vertex" to the "to vertex".  Also keep track of the vertices
-	// in the surrounding triangles. 
-	void updateTriangles(EdgeCollapse &ec, vertex &vc, set<int> &affectedVerts, Mesh &mesh);
+	// in the surrounding triangles (sorted, w/o repeats).  triNeighbors is
+	// scratch space.
+	void updateTriangles(EdgeCollapse &ec, vertex vc, vector<int> &affectedVerts, Mesh &mesh,
+						 vector<int> &triNeighbors);
 
 
 	// These affected vertices are not in the current collapse, 
 	// but are in the triangles which share the collapsed edge.
-	void updateAffectedVertNeighbors(vertex &vert, const EdgeCollapse &ec, 
-		const set<int> &affectedVerts);
-
-	// Reset the edge collapse costs of vertices which were
-	// affected by a previous edge collapse.
-	void resetAffectedVertCosts(const EdgeCost &cost, Mesh &newmesh, vertex &vert);
+	void updateAffectedVertNeighbors(vertex vert, const EdgeCollapse &ec, 
+		const vector<int> &affectedVerts, Mesh &mesh);
 
 	// If this vertex has no active triangles (i.e. triangles which have
 	// not been removed from the mesh) then set it to inactive.
-	void removeVertIfNecessary(vertex &vert, vertexPtrSet &vertSet, 
-								  vector<vertexPtrSet::iterator> &vertSetVec, 
-								  Mesh &mesh, const EdgeCost &cost, 
-									set<int> &affectedQuadricVerts);
+	void removeVertIfNecessary(vertex vert, CostHeap &vertHeap, Mesh &mesh);
 
 	// Update the vertices affected by the most recent edge collapse
-	void updateAffectedVerts(Mesh &_newmesh, vector<vertexPtrSet::iterator> &vertSetVec, 
-							vertexPtrSet &vertSet, const EdgeCollapse &ec, 
-							set<int> &affectedVerts, const EdgeCost &cost, 
-							set<int> &affectedQuadricVerts);
+	template <class Cost> void updateAffectedVerts(Mesh &_newmesh, CostHeap &vertHeap, 
+												   const EdgeCollapse &ec, 
+												   CollapseScratch &scratch);
 
-	// Recalculate the QEM matrices (yeah, that's redundant) if we're
-	// using the Quadrics to calculate edge collapse costs.
-	void recalcQuadricCollapseCosts(set<int> &affectedQuadricVerts, 
-								   Mesh &mesh, const EdgeCost &cost);
+	// Link the corners of the triangles again after an edge collapse
+	void relinkCorners(const EdgeCollapse &ec, Mesh &mesh);
+	void relinkRemovedTriCorners(const EdgeCollapse &ec, Mesh &mesh);
 
 	// Calculate the list of edge collapses.  Each edge collapse
 	// consists of two vertices:  a "from vertex" and a "to vertex".
 	// The "from vertex" is collapsed to the "to vertex".  The
 	// "from vertex" is removed from the mesh.
-	void buildEdgeCollapseList(Mesh &mesh, const EdgeCost &cost, 
-							  list<EdgeCollapse> &_edgeCollList,
-								vertexPtrSet &vertSet, 
-								vector<vertexPtrSet::iterator> &vertSetVec);
+	template <class Cost> void buildEdgeCollapseList(Mesh &mesh, 
+													 CollapseHistory &history,
+													 CostHeap &vertHeap, int nVisTris);
+
+	// The quadric methods build the list of edge collapses from a heap
+	// of edges, instead of a heap of vertices.  After a collapse, only
+	// the edges of the "to vertex" (whose quadric changed) get new costs.
+	template <class Cost> void buildQuadricEdges(Mesh &mesh, QuadricEdges &edges);
+	template <class Cost> void buildQuadricEdgeCollapseList(Mesh &mesh, CollapseHistory &history,
+															QuadricEdges &edges, int nVisTris);
+
+	// Calculate the cost of an edge, & which way to collapse it.  pos is
+	// where the vertex which is left goes.
+	template <class Cost> double orientQuadricEdge(Mesh &mesh, int* ev);
+	template <class Cost> double orientQuadricEdge(Mesh &mesh, int* ev, Vec3 &pos);
+	template <class Cost> void calcQuadricEdgeCost(Mesh &mesh, QuadricEdges &edges, int e);
+
+	// Move the edges of the "from vertex" to the "to vertex", remove the
+	// edges of vertices which are gone, then recalculate the edge costs
+	// of the "to vertex".
+	template <class Cost> void updateQuadricEdges(const EdgeCollapse &ec, CollapseScratch &scratch, 
+												  Mesh &mesh, QuadricEdges &edges);
+
+	// The first part of updateQuadricEdges():  move the edges, & find the
+	// edges to remove (which are left in the heap & the rows of the other
+	// vertices).
+	void moveQuadricEdges(const EdgeCollapse &ec, const vector<int> &affectedVerts, 
+						  Mesh &mesh, QuadricEdges &edges, vector<int> &removedEdges);
+
+	// Build the list of edge collapses in parallel.  Each round picks a
+	// batch of the cheapest edge collapses which don't overlap, does them
+	// at the same time, then updates the costs of the vertices (or edges)
+	// around them.  The list has the collapses in the order they were
+	// picked, so it's replayed like a serial one.
+	enum {MIN_CANDIDATES = 64, CANDIDATE_FRACTION = 32}; // candidates are at most 1/CANDIDATE_FRACTION of the heap
+	void startBatch(CollapseBatch &batch, int heapSize, int &maxCandidates);
+	bool pickBatch(Mesh &mesh, CollapseBatch &batch, QuadricEdges *edges,
+				   int nCollapses, int nVisTris, vector<int> &deferred);
+	bool claimCollapse(const EdgeCollapse &ec, const vector<int> &verts, Mesh &mesh,
+					   CollapseBatch &batch, QuadricEdges *edges);
+	bool appendBatch(const CollapseBatch &batch, CollapseHistory &history,
+					 int &nCollapses, int &nVisTris);
+	template <class Cost> void buildBatchedEdgeCollapseList(Mesh &mesh, 
+															CollapseHistory &history,
+															CostHeap &vertHeap, int nVisTris);
+	template <class Cost> void buildBatchedQuadricEdgeCollapseList(Mesh &mesh, CollapseHistory &history,
+																   QuadricEdges &edges, int nVisTris);
 
 	// Helper function for melaxCollapseCost().  This function
 	// will loop through all the triangles to which this vertex
-	// belongs.
-	void calcMelaxMaxValue(Mesh &mesh, set<int> &adjfaces, 
-							  vertex &v, set<int> &tneighbors,
+	// belongs.  The normals of the triangles are gathered once for
+	// each vertex:  faceNormals are those of the active triangles 
+	// around it, & edgeNormals those of the triangles on the edge.
+	void calcMelaxMaxValue(const vector<Vec3> &edgeNormals, 
+							  bool bBorder, const vector<Vec3> &faceNormals,
 								float &retmaxValue, 
 								bool &bMaxValueFound);
 };
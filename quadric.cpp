@@ -0,0 +1,40 @@
+
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include "quadric.h"
+
+// The point w/ the smallest error is where the gradient of v^T Q v is
+// 0.  This is the solution of the 3x3 system made from the upper left
+// of Q, w/ the negated last column on the right.  It's solved in double
+// precision, whatever the precision of the quadric.
+bool Quadric::optimize(Vec3& pos) const
+{
+	const double a2 = _q[0], ab = _q[1], ac = _q[2], ad = _q[3];
+	const double b2 = _q[4], bc = _q[5], bd = _q[6];
+	const double c2 = _q[7], cd = _q[8];
+
+	// Cofactors of the (symmetric) 3x3 matrix
+	const double c00 = b2 * c2 - bc * bc;
+	const double c01 = bc * ac - ab * c2;
+	const double c02 = ab * bc - b2 * ac;
+	const double c11 = a2 * c2 - ac * ac;
+	const double c12 = ab * ac - a2 * bc;
+	const double c22 = a2 * b2 - ab * ab;
+	const double det = a2 * c00 + ab * c01 + ac * c02;
+
+	// Compare the determinant to the size of the matrix, so the test
+	// doesn't depend on the scale of the mesh
+	const double scale = (fabs(a2) + fabs(b2) + fabs(c2)) / 3;
+	if (!(fabs(det) > 1e-12 * scale * scale * scale)) return false;
+
+	// Cramer's rule
+	pos.x = (float) (-(c00 * ad + c01 * bd + c02 * cd) / det);
+	pos.y = (float) (-(c01 * ad + c11 * bd + c12 * cd) / det);
+	pos.z = (float) (-(c02 * ad + c12 * bd + c22 * cd) / det);
+	return true;
+}
@@ -0,0 +1,174 @@
+
+
+#ifndef __quadric_h
+#define __quadric_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include "vec3.h"
+
+// The quadrics are stored as doubles, unless QUADRIC_FLOAT is defined.
+// Floats take half the memory, but the errors of nearly flat areas
+// lose most of their precision.
+#if defined (QUADRIC_FLOAT)
+typedef float QuadricReal;
+#else
+typedef double QuadricReal;
+#endif
+
+// The SIMD instructions used to add & scale quadrics:  AVX
+// if the compiler is targeting it, else SSE2 (which every x64 CPU has),
+// else none.
+#if defined (__AVX__)
+#include <immintrin.h>
+#define QUADRIC_AVX
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUADRIC_SSE2
+#endif
+
+
+// Garland & Heckbert's error quadric.  It's a symmetric 4x4 matrix Q,
+// & the error of a point v is v^T Q v (w/ v = [x y z 1]), i.e. the
+// summed squared distance from v to the planes added into Q.  Since Q
+// is symmetric, only the 10 coefficients on & above the diagonal are
+// stored, row by row:
+//
+//  a2 ab ac ad
+//     b2 bc bd
+//        c2 cd
+//           d2
+class Quadric
+{
+public:
+	enum {COEFFS = 10};
+
+	Quadric() {setZero();}
+
+	// Quadric of the plane ax + by + cz + d = 0 (w/ a unit normal)
+	Quadric(float a, float b, float c, float d)
+	{
+		_q[0] = a * a; _q[1] = a * b; _q[2] = a * c; _q[3] = a * d;
+		_q[4] = b * b; _q[5] = b * c; _q[6] = b * d;
+		_q[7] = c * c; _q[8] = c * d;
+		_q[9] = d * d;
+	}
+
+	void setZero()
+	{
+		for (int i = 0; i < COEFFS; ++i) _q[i] = 0;
+	}
+
+	Quadric& operator+=(const Quadric& q)
+	{
+		int i = 0;
+		for (; i + LANES <= COEFFS; i += LANES)
+		{
+			store(&_q[i], add(load(&_q[i]), load(&q._q[i])));
+		}
+		for (; i < COEFFS; ++i) _q[i] += q._q[i];
+		return *this;
+	}
+
+	// The sum is stored straight from the lanes.  (Copying *this, then
+	// adding q to it, reloads the copy before its stores are done, which
+	// stalls w/ AVX.)
+	Quadric operator+(const Quadric& q) const
+	{
+		Quadric sum(NO_INIT);
+		int i = 0;
+		for (; i + LANES <= COEFFS; i += LANES)
+		{
+			store(&sum._q[i], add(load(&_q[i]), load(&q._q[i])));
+		}
+		for (; i < COEFFS; ++i) sum._q[i] = _q[i] + q._q[i];
+		return sum;
+	}
+
+	Quadric& operator*=(QuadricReal s)
+	{
+		const Lanes ls = set1(s);
+		int i = 0;
+		for (; i + LANES <= COEFFS; i += LANES)
+		{
+			store(&_q[i], mul(load(&_q[i]), ls));
+		}
+		for (; i < COEFFS; ++i) _q[i] *= s;
+		return *this;
+	}
+
+	// The error at point v:  v^T Q v.  The coefficients off the diagonal
+	// are used twice, so it's factored by x, then y, then z.  (This is
+	// about twice as fast as the full 4x4 product, & faster than doing
+	// it in SIMD lanes, which have to be loaded & summed across.)
+	double evaluate(const Vec3& v) const
+	{
+		const QuadricReal x = v.x;
+		const QuadricReal y = v.y;
+		const QuadricReal z = v.z;
+		return x * (_q[0] * x + 2 * (_q[1] * y + _q[2] * z + _q[3])) +
+			   y * (_q[4] * y + 2 * (_q[5] * z + _q[6])) +
+			   z * (_q[7] * z + 2 * _q[8]) + _q[9];
+	}
+
+	// Find the point w/ the smallest error.  Returns false if there's no
+	// single point, i.e. the planes are all parallel, or all share a line.
+	bool optimize(Vec3& pos) const;
+
+private:
+	QuadricReal _q[COEFFS];
+
+	enum NoInit {NO_INIT};
+	Quadric(NoInit) {}
+
+	// The SIMD lanes, & the operations on them.  w/o SIMD, a "lane" is
+	// one coefficient.
+#if defined (QUADRIC_AVX) && defined (QUADRIC_FLOAT)
+	typedef __m256 Lanes;
+	enum {LANES = 8};
+	static Lanes load(const float* p) {return _mm256_loadu_ps(p);}
+	static void store(float* p, Lanes l) {_mm256_storeu_ps(p, l);}
+	static Lanes add(Lanes l1, Lanes l2) {return _mm256_add_ps(l1, l2);}
+	static Lanes mul(Lanes l1, Lanes l2) {return _mm256_mul_ps(l1, l2);}
+	static Lanes set1(float f) {return _mm256_set1_ps(f);}
+#elif defined (QUADRIC_AVX)
+	typedef __m256d Lanes;
+	enum {LANES = 4};
+	static Lanes load(const double* p) {return _mm256_loadu_pd(p);}
+	static void store(double* p, Lanes l) {_mm256_storeu_pd(p, l);}
+	static Lanes add(Lanes l1, Lanes l2) {return _mm256_add_pd(l1, l2);}
+	static Lanes mul(Lanes l1, Lanes l2) {return _mm256_mul_pd(l1, l2);}
+	static Lanes set1(double f) {return _mm256_set1_pd(f);}
+#elif defined (QUADRIC_SSE2) && defined (QUADRIC_FLOAT)
+	typedef __m128 Lanes;
+	enum {LANES = 4};
+	static Lanes load(const float* p) {return _mm_loadu_ps(p);}
+	static void store(float* p, Lanes l) {_mm_storeu_ps(p, l);}
+	static Lanes add(Lanes l1, Lanes l2) {return _mm_add_ps(l1, l2);}
+	static Lanes mul(Lanes l1, Lanes l2) {return _mm_mul_ps(l1, l2);}
+	static Lanes set1(float f) {return _mm_set1_ps(f);}
+#elif defined (QUADRIC_SSE2)
+	typedef __m128d Lanes;
+	enum {LANES = 2};
+	static Lanes load(const double* p) {return _mm_loadu_pd(p);}
+	static void store(double* p, Lanes l) {_mm_storeu_pd(p, l);}
+	static Lanes add(Lanes l1, Lanes l2) {return _mm_add_pd(l1, l2);}
+	static Lanes mul(Lanes l1, Lanes l2) {return _mm_mul_pd(l1, l2);}
+	static Lanes set1(double f) {return _mm_set1_pd(f);}
+#else
+	typedef QuadricReal Lanes;
+	enum {LANES = 1};
+	static Lanes load(const QuadricReal* p) {return *p;}
+	static void store(QuadricReal* p, Lanes l) {*p = l;}
+	static Lanes add(Lanes l1, Lanes l2) {return l1 + l2;}
+	static Lanes mul(Lanes l1, Lanes l2) {return l1 * l2;}
+	static Lanes set1(QuadricReal f) {return f;}
+#endif
+};
+
+#endif // __quadric_h
@@ -0,0 +1,278 @@
+// Headless test of PMesh's index buffer (see PMesh::getIndices()).
+//
+// A mesh is simplified & restored by random sequences of edge
+// collapses, vertex splits, jumps to another level of detail & view-
+// dependent refinement.  After each one, a copy of the index buffer which
+// is only updated from the dirty ranges (like an OpenGL buffer would
+// be), & the buffer itself, are checked against a full rebuild from the
+// visible triangles.
+//
+// It's a console program, linked w/ the sources which don't use OpenGL,
+// e.g. from this directory:
+//
+//   cl /EHsc /O2 /openmp /I.. indexbuffertest.cpp ..\adjacency.cpp
+//      ..\collapsehistory.cpp ..\cornertable.cpp ..\costheap.cpp
+//      ..\mappedfile.cpp ..\mesh.cpp ..\pmesh.cpp ..\quadric.cpp
+//      ..\triangle.cpp ..\vec3.cpp ..\vertex.cpp ..\vertexhierarchy.cpp
+//      user32.lib
+//
+// Run it w/ no arguments to test a generated grid w/ holes in it, or
+// pass the name of a PLY file.  It prints PASS or FAIL, & returns 0 if
+// every check passed.
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#pragma warning(disable:4786) // disable "identifier was truncated to '255' characters in the browser information" warning in Visual C++ 6*
+#endif
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "mesh.h"
+#include "pmesh.h"
+#include "vertexhierarchy.h"
+
+using namespace std;
+
+const int GRID_SIZE = 40; // vertices along each side of the generated grid
+const int NUM_STEPS = 300; // random changes for each edge cost method
+
+// The same pseudo-random numbers on every platform
+static unsigned g_seed = 12345;
+static int randomInt(int n)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return (int) ((g_seed >> 16) % (unsigned) n);
+}
+
+// The vertices of one triangle, sorted into the same order whichever
+// copy they come from
+struct TriVerts
+{
+	int v[3];
+
+	bool operator<(const TriVerts& t) const
+	{
+		return lexicographical_compare(v, v + 3, t.v, t.v + 3);
+	}
+	bool operator==(const TriVerts& t) const
+	{
+		return equal(v, v + 3, t.v);
+	}
+};
+
+// Write a bumpy grid, w/ some squares left out so it has holes & borders
+static bool writeGridPly(const char* filename)
+{
+	FILE* outFile = fopen(filename, "w");
+	if (!outFile) return false;
+
+	vector<int> faces;
+	int i, j;
+	for (i = 0; i < GRID_SIZE - 1; ++i)
+	{
+		for (j = 0; j < GRID_SIZE - 1; ++j)
+		{
+			if (0 == (i / 4 + j / 3) % 7 && 1 == i % 4) continue; // a hole
+
+			const int v = i * GRID_SIZE + j;
+			faces.push_back(v);
+			faces.push_back(v + 1);
+			faces.push_back(v + GRID_SIZE);
+			faces.push_back(v + 1);
+			faces.push_back(v + GRID_SIZE + 1);
+			faces.push_back(v + GRID_SIZE);
+		}
+	}
+
+	fprintf(outFile, "ply\nformat ascii 1.0\n");
+	fprintf(outFile, "element vertex %d\n", GRID_SIZE * GRID_SIZE);
+	fprintf(outFile, "property float x\nproperty float y\nproperty float z\n");
+	fprintf(outFile, "element face %d\n", (int) faces.size() / 3);
+	fprintf(outFile, "property list uchar int vertex_indices\nend_header\n");
+	for (i = 0; i < GRID_SIZE; ++i)
+	{
+		for (j = 0; j < GRID_SIZE; ++j)
+		{
+			const float x = (float) j / (GRID_SIZE - 1), y = (float) i / (GRID_SIZE - 1);
+			fprintf(outFile, "%g %g %g\n", x, y, 0.1 * sin(7 * x) * cos(5 * y));
+		}
+	}
+	for (i = 0; i < (int) faces.size(); i += 3)
+	{
+		fprintf(outFile, "3 %d %d %d\n", faces[i], faces[i + 1], faces[i + 2]);
+	}
+	fclose(outFile);
+	return true;
+}
+
+// A view from a random point around the mesh, which sees all of it
+static void randomView(ViewParams& view)
+{
+	view._eye = Vec3(randomInt(400) / 100.0f - 2, randomInt(400) / 100.0f - 2, randomInt(300) / 100.0f + 0.2f);
+	for (int i = 0; i < 6; ++i)
+	{
+		view._planes[i][0] = view._planes[i][1] = view._planes[i][2] = 0;
+		view._planes[i][3] = 1;
+	}
+	view._pixelsPerUnit = 600;
+	view._maxError = (float) (1 + randomInt(8));
+}
+
+// Copy the dirty ranges into the copy of the buffer, then compare both
+// to the visible triangles.  Returns the # of errors.
+static int checkIndices(PMesh& pm, vector<int>& copy, int step)
+{
+	int nErrors = 0;
+	int i, k;
+
+	const int* indices = pm.getIndices();
+	for (i = 0; i < pm.numDirtyRanges(); ++i)
+	{
+		int first, last;
+		pm.getDirtyRange(i, first, last);
+		for (k = 3 * first; k < 3 * last; ++k) copy[k] = indices[k];
+	}
+	pm.clearDirtyRanges();
+
+	// The full rebuild
+	vector<TriVerts> visible;
+	triangle t;
+	for (i = 0; i < pm.numTris(); ++i)
+	{
+		pm.getTri(i, t);
+		if (!t.isActive()) continue;
+
+		TriVerts tv;
+		t.getVerts(tv.v[0], tv.v[1], tv.v[2]);
+		if (!pm.isViewRefined() && i < pm.numVisTris() &&
+			!equal(tv.v, tv.v + 3, indices + 3 * i))
+		{
+			// In order, triangle i should be in slot i
+			if (nErrors++ < 5) printf("step %d:  triangle %d isn't in its own slot\n", step, i);
+		}
+		sort(tv.v, tv.v + 3);
+		visible.push_back(tv);
+	}
+
+	if ((int) visible.size() != pm.numVisTris())
+	{
+		printf("step %d:  %d visible triangles, but numVisTris() is %d\n", step,
+			   (int) visible.size(), pm.numVisTris());
+		return nErrors + 1;
+	}
+
+	vector<TriVerts> buffer(pm.numVisTris()), copied(pm.numVisTris());
+	for (i = 0; i < pm.numVisTris(); ++i)
+	{
+		for (k = 0; k < 3; ++k)
+		{
+			buffer[i].v[k] = indices[3 * i + k];
+			copied[i].v[k] = copy[3 * i + k];
+		}
+		sort(buffer[i].v, buffer[i].v + 3);
+		sort(copied[i].v, copied[i].v + 3);
+	}
+	if (!equal(copy.begin(), copy.begin() + pm.numIndices(), indices))
+	{
+		if (nErrors++ < 5) printf("step %d:  the copy from the dirty ranges is out of date\n", step);
+	}
+
+	sort(visible.begin(), visible.end());
+	sort(buffer.begin(), buffer.end());
+	sort(copied.begin(), copied.end());
+	if (!(visible == buffer))
+	{
+		if (nErrors++ < 5) printf("step %d:  the buffer has the wrong triangles\n", step);
+	}
+	if (!(visible == copied))
+	{
+		if (nErrors++ < 5) printf("step %d:  the copy has the wrong triangles\n", step);
+	}
+	return nErrors;
+}
+
+// Make NUM_STEPS random changes to the level of detail, checking the
+// index buffer after each one
+static int testEdgeCost(Mesh& mesh, PMesh::EdgeCost ec, int checkpointInterval)
+{
+	PMesh pm(&mesh, ec);
+	pm.setCheckpointInterval(checkpointInterval);
+	const int nCollapses = pm.numCollapses();
+
+	// The whole buffer is copied once, & then only the dirty ranges
+	vector<int> copy(pm.getIndices(), pm.getIndices() + 3 * (size_t) pm.numTris());
+	pm.clearDirtyRanges();
+
+	int nErrors = 0;
+	int i;
+	for (int step = 0; step < NUM_STEPS && nErrors < 5; ++step)
+	{
+		const int r = randomInt(10);
+		if (r < 3)
+		{
+			const int n = 1 + randomInt(50);
+			for (i = 0; i < n; ++i) pm.collapseEdge();
+		}
+		else if (r < 5)
+		{
+			const int n = 1 + randomInt(50);
+			for (i = 0; i < n; ++i) pm.splitVertex();
+		}
+		else if (r < 7)
+		{
+			pm.setCollapseIndex(randomInt(nCollapses + 1));
+		}
+		else if (r < 8)
+		{
+			pm.setVisibleTriangleCount(randomInt(pm.numTris() + 1));
+		}
+		else
+		{
+			ViewParams view;
+			randomView(view);
+			pm.refineForView(view, 1.0);
+		}
+		nErrors += checkIndices(pm, copy, step);
+	}
+
+	printf("%s, checkpoint interval %d:  %d edge collapses, %s\n", pm.getEdgeCostDesc(),
+		   checkpointInterval, nCollapses, nErrors ? "FAIL" : "ok");
+	return nErrors;
+}
+
+int main(int argc, char** argv)
+{
+	char gridFilename[] = "indexbuffertest.ply";
+	char* filename = gridFilename;
+	if (argc > 1)
+	{
+		filename = argv[1];
+	}
+	else if (!writeGridPly(gridFilename))
+	{
+		printf("Can't write %s\nFAIL\n", gridFilename);
+		return 1;
+	}
+
+	Mesh mesh(filename);
+	if (argc <= 1) remove(gridFilename);
+	if (0 == mesh.getNumTriangles())
+	{
+		printf("Can't load %s\nFAIL\n", filename);
+		return 1;
+	}
+
+	int nErrors = 0;
+	for (int ec = 0; ec < PMesh::MAX_EDGECOST; ++ec)
+	{
+		nErrors += testEdgeCost(mesh, (PMesh::EdgeCost) ec, 0);
+		nErrors += testEdgeCost(mesh, (PMesh::EdgeCost) ec, 50);
+	}
+
+	printf(nErrors ? "FAIL\n" : "PASS\n");
+	return nErrors ? 1 : 0;
+}
@@ -16,9 +16,9 @@ const float* triangle::getVert2() {return (_mesh->getVertex(_vert2)).getArrayVer
 const float* triangle::getVert3() {return (_mesh->getVertex(_vert3)).getArrayVerts();}
 
 // retrieve vertices as a vertex object
-const vertex& triangle::getVert1vertex() const {return _mesh->getVertex(_vert1);};
-const vertex& triangle::getVert2vertex() const {return _mesh->getVertex(_vert2);};
-const vertex& triangle::getVert3vertex() const {return _mesh->getVertex(_vert3);};
+vertex triangle::getVert1vertex() const {return _mesh->getVertex(_vert1);};
+vertex triangle::getVert2vertex() const {return _mesh->getVertex(_vert2);};
+vertex triangle::getVert3vertex() const {return _mesh->getVertex(_vert3);};
 
 // Calculate normal of triangle
 void
@@ -26,9 +26,10 @@ triangle::calcNormal()
 {
 	assert(_mesh);
 
-	Vec3 vec1 = (_mesh->getVertex(_vert1)).getXYZ();
-	Vec3 vec2 = (_mesh->getVertex(_vert2)).getXYZ();
-	Vec3 vec3 = (_mesh->getVertex(_vert3)).getXYZ();
+	const Vec3* positions = _mesh->getVertexArrays().getPositions();
+	Vec3 vec1 = positions[_vert1];
+	Vec3 vec2 = positions[_vert2];
+	Vec3 vec3 = positions[_vert3];
 	Vec3 veca = vec2 - vec1;
 	Vec3 vecb = vec3 - vec2;
 
@@ -50,9 +51,10 @@ triangle::calcArea()
 	// If a triangle is defined by 3 points, say p, q and r, then
 	// its area is 0.5 * length of ((p - r) cross (q - r))
 	// See Real-Time Rendering book, Appendix A
-	Vec3 vec1 = (_mesh->getVertex(_vert1)).getXYZ();
-	Vec3 vec2 = (_mesh->getVertex(_vert2)).getXYZ();
-	Vec3 vec3 = (_mesh->getVertex(_vert3)).getXYZ();
+	const Vec3* positions = _mesh->getVertexArrays().getPositions();
+	Vec3 vec1 = positions[_vert1];
+	Vec3 vec2 = positions[_vert2];
+	Vec3 vec3 = positions[_vert3];
 	Vec3 vecA = vec1 - vec2;
 	Vec3 vecB = vec3 - vec2;
 
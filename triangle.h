@@ -53,7 +53,7 @@ public:
 		_mesh(t._mesh), bActive(t.bActive),
 		_index(t._index)
 	{
-		calcNormal();
+		if (_mesh) calcNormal(); // default triangles have no mesh yet
 	};
 
 	// assignment operator
@@ -65,6 +65,7 @@ public:
 		_vert3 = t._vert3;
 		_mesh = t._mesh;
 		_normal = t._normal;
+		_d = t._d;
 		bActive = t.bActive;
 		_index = t._index;
 		return *this;
@@ -89,7 +90,7 @@ public:
 	bool isActive() const {return bActive;};
 	void setActive(bool b) {bActive = b;};
 
-	bool hasVertex(int vi) {
+	bool hasVertex(int vi) const {
 		return	(vi == _vert1 ||
 				 vi == _vert2 ||
 				 vi == _vert3);}
@@ -115,14 +116,15 @@ public:
 	}
 
 	void getVerts(int& v1, int& v2, int& v3) {v1=_vert1;v2=_vert2;v3=_vert3;}
+	void setVerts(int v1, int v2, int v3) {_vert1=v1;_vert2=v2;_vert3=v3;}
 
 	const float* getVert1();
 	const float* getVert2();
 	const float* getVert3();
 
-	const vertex& getVert1vertex() const;
-	const vertex& getVert2vertex() const;
-	const vertex& getVert3vertex() const;
+	vertex getVert1vertex() const;
+	vertex getVert2vertex() const;
+	vertex getVert3vertex() const;
 
 	float* getNormal() {_normArray[0]=_normal.x;
 						_normArray[1]=_normal.y;
@@ -136,6 +138,7 @@ public:
 	int getVert1Index() const {return _vert1;}
 	int getVert2Index() const {return _vert2;}
 	int getVert3Index() const {return _vert3;}
+	int getVertIndex(int k) const {return (0 == k) ? _vert1 : ((1 == k) ? _vert2 : _vert3);} // vertex at corner k (0, 1 or 2)
 	const Vec3& getNormalVec3() const {return _normal;}
 
 	int getIndex() const {return _index;}
@@ -34,8 +34,8 @@ public:
 	Vec3& operator=(const Vec3& v) {x = v.x; y = v.y; z = v.z; return *this;};
 
 	// Comparision operators
-	bool operator==(const Vec3& v) {return (x == v.x && y == v.y && z == v.z);};
-	bool operator!=(const Vec3& v) {return (x != v.x || y != v.y || z != v.z);};
+	bool operator==(const Vec3& v) const {return (x == v.x && y == v.y && z == v.z);};
+	bool operator!=(const Vec3& v) const {return (x != v.x || y != v.y || z != v.z);};
 
 	// Scalar operations
 	Vec3 operator+(float f) const {return Vec3(x + f, y + f, z + f);};
@@ -20,6 +20,7 @@
 #include <set>
 
 #include "vec3.h"
+#include "quadric.h"
 #include "triangle.h"
 
 using namespace std;
@@ -27,131 +28,122 @@ using namespace std;
 class Mesh;
 
 // Used to store an edge -- two vertices which have only one
-// triangle in common form an edge of the mesh.
+// triangle in common form an edge of the mesh.  The smaller vertex
+// index is stored first.
 struct border
 {
 	int vert1;
 	int vert2;
 	int triIndex;
 
-	// We need operator< because it's used by the STL's set<> to determine equality
-	// (if (not a<b) and (not b>a) then a is equal to b)
+	// Border edges are sorted by their vertices
 	bool operator<(const border& b) const 
 	{
-		int v1, v2, b1, b2;
-		// make sure the smaller vert index is always first.
-		if (vert1 < vert2) {
-			v1 = vert1; v2 = vert2;
-		} else {
-			v1 = vert2; v2 = vert1;
-		}
-		if (b.vert1 < b.vert2) {
-			b1 = b.vert1; b2 = b.vert2;
-		} else {
-			b1 = b.vert2; b2 = b.vert1;
-		}
-		if (v1 < b1) return true;
-		if (v1 > b1) return false;
-		return (v2 < b2); // v1 == b1
+		return (vert1 < b.vert1 || (vert1 == b.vert1 && vert2 < b.vert2));
+	}
+	bool operator==(const border& b) const 
+	{
+		return (vert1 == b.vert1 && vert2 == b.vert2);
 	}
 };
 
-// A vertex has both a position and a normal
-class vertex
+// The vertices of a mesh, stored as a structure of arrays.  Each pass
+// over the vertices only pulls the arrays it uses into the cache (e.g.
+// the positions, or the edge collapse costs), rather than the whole
+// vertex.  Vertex i is entry i of every array.
+class VertexArrays
 {
 public:
-	// Constructors and Destructors
-	vertex() : 
-		_myVertex(0.0, 0.0, 0.0), _vertexNormal(0.0, 0.0, 0.0), 
-		_bActive(false), _cost(0), _minCostNeighbor(-1),
-		_index(-1), _QTriArea(0)
-	{
-		initQuadric();
-	};
+	VertexArrays() {};
 
-	vertex(float x1, float y1, float z1) : 
-		_myVertex(x1, y1, z1), _vertexNormal(0.0, 0.0, 0.0), 
-		_bActive(true), _cost(0), _minCostNeighbor(-1),
-		_index(-1), _QTriArea(0)
-	{
-		initQuadric();
-	};
+	int size() const {return (int) _positions.size();}
 
-	vertex(float av[3]): 
-		_myVertex(av), _vertexNormal(0.0, 0.0, 0.0), 
-		_bActive(true), _cost(0), _minCostNeighbor(-1),
-		_index(-1), _QTriArea(0)
+	// Add or remove vertices.  New vertices are at the origin, inactive,
+	// & have no edge collapse cost.
+	void resize(int n)
 	{
-		initQuadric();
-	};
+		_positions.resize(n);
+		_normals.resize(n);
+		_costs.resize(n, 0);
+		_minCostNeighbors.resize(n, -1);
+		if (hasQuadrics())
+		{
+			_quadrics.resize(n);
+			_quadricTriAreas.resize(n, 0);
+		}
+		_active.resize(n, 0);
+	}
 
-	vertex(float av[3], float vn[3]): 
-		_myVertex(av), _vertexNormal(vn), 
-		_bActive(true),_cost(0), _minCostNeighbor(-1),
-		_index(-1), _QTriArea(0)
-	{
-		initQuadric();
-	};
-
-	// copy ctor
-	vertex(const vertex& v) : _myVertex(v._myVertex), _vertexNormal(v._vertexNormal),
-							_vertNeighbors(v._vertNeighbors), _triNeighbors(v._triNeighbors),
-							_bActive(v._bActive), _cost(v._cost), 
-							_minCostNeighbor(v._minCostNeighbor),
-							_index(v._index), _QTriArea(v._QTriArea)
+	void clear() {resize(0); _quadrics.clear(); _quadricTriAreas.clear();}
+
+	// The quadrics are only used by the quadric edge collapse methods,
+	// so they aren't allocated until one of those asks for them.
+	// allocQuadrics() resets them (& their triangle areas) if they were
+	// already allocated.
+	bool hasQuadrics() const {return !_quadricTriAreas.empty();}
+	void allocQuadrics()
 	{
-		// copy quadric
-		for (int i = 0; i < 4; ++i) {
-			for (int j = 0; j < 4; ++j) {
-				_Q[i][j] = v._Q[i][j];
-			}
-		}		
-	};
-
-	// destructor
-	~vertex() {_vertNeighbors.erase(_vertNeighbors.begin(), _vertNeighbors.end());
-				_triNeighbors.erase(_triNeighbors.begin(), _triNeighbors.end());};
-
-	// Assignment operator
-	vertex& operator=(const vertex& v) 
+		_quadrics.assign(_positions.size(), Quadric());
+		_quadricTriAreas.assign(_positions.size(), 0);
+	}
+
+	// Positions & normals are packed x, y, z, so they can be handed
+	// to OpenGL as arrays of floats.
+	const Vec3* getPositions() const {return _positions.empty() ? 0 : &_positions[0];}
+	const Vec3* getNormals() const {return _normals.empty() ? 0 : &_normals[0];}
+
+	// Renumber the vertices:  vertex i becomes vertex newIndex[i].  (The
+	// min. cost neighbors are renumbered too.)
+	void renumber(const vector<int>& newIndex)
 	{
-		if (this == &v) return *this; // check for assignment to self
-		_myVertex =v._myVertex;
-		_vertexNormal = v._vertexNormal; 
-		_vertNeighbors = v._vertNeighbors;
-		_triNeighbors = v._triNeighbors;
-		_bActive = v._bActive;
-		_cost = v._cost;
-		_minCostNeighbor = v._minCostNeighbor;
-		_index = v._index;
-		_QTriArea = v._QTriArea;
-		// copy quadric
-		for (int i = 0; i < 4; ++i) {
-			for (int j = 0; j < 4; ++j) {
-				_Q[i][j] = v._Q[i][j];
-			}
+		scatter(_positions, newIndex);
+		scatter(_normals, newIndex);
+		scatter(_costs, newIndex);
+		scatter(_minCostNeighbors, newIndex);
+		scatter(_quadrics, newIndex);
+		scatter(_quadricTriAreas, newIndex);
+		scatter(_active, newIndex);
+		for (int i = 0; i < (int) _minCostNeighbors.size(); ++i)
+		{
+			if (_minCostNeighbors[i] >= 0) _minCostNeighbors[i] = newIndex[_minCostNeighbors[i]];
 		}
-		return *this;
-	};
-	// Assignment operator
-	vertex& operator=(const float av[3])
+	}
+
+private:
+	friend class vertex;
+
+	// Move entry i of an array to entry newIndex[i]
+	template <class T> static void scatter(vector<T>& a, const vector<int>& newIndex)
 	{
-		_myVertex.x=av[0];_myVertex.y=av[1];_myVertex.z=av[2];
-		// erase the list of neighboring vertices, faces
-		// since we're copying from an array of floats
-		_vertNeighbors.erase(_vertNeighbors.begin(), _vertNeighbors.end());
-		_triNeighbors.erase(_triNeighbors.begin(), _triNeighbors.end());
-		_cost = 0;
-		_minCostNeighbor = -1;
-		_index = -1;
-		_QTriArea = 0;
-		initQuadric();
-		return *this;
-	};
+		if (a.empty()) return;
+		vector<T> b(a.size());
+		for (int i = 0; i < (int) a.size(); ++i) b[newIndex[i]] = a[i];
+		a.swap(b);
+	}
+
+	vector<Vec3> _positions; // X, Y, Z position of each vertex
+	vector<Vec3> _normals; // vertex normals, used for Gouraud shading
+
+	vector<double> _costs; // cost of removing each vertex from Progressive Mesh
+	vector<int> _minCostNeighbors; // index of vertex at other end of the min. cost edge
+
+	vector<Quadric> _quadrics; // quadric for each vertex
+	vector<double> _quadricTriAreas; // summed area of triangles used to computer quadrics
+
+	vector<unsigned char> _active; // false if vertex has been removed
+};
+
+// A vertex has both a position and a normal.  This is a handle to one
+// vertex of a mesh:  the data is stored in the mesh's VertexArrays, so
+// copying a vertex copies the handle, not the data.
+class vertex
+{
+public:
+	vertex(VertexArrays* verts, int index) : _verts(verts), _index(index) {};
 
 	// Comparision operators
-	bool operator==(const vertex& v) {return (_myVertex == v._myVertex && _vertexNormal == v._vertexNormal);};
-	bool operator!=(const vertex& v) {return (_myVertex != v._myVertex || _vertexNormal != v._vertexNormal);};
+	bool operator==(const vertex& v) {return (_verts->_positions[_index] == v.getXYZ() && _verts->_normals[_index] == v.getNormal());};
+	bool operator!=(const vertex& v) {return (_verts->_positions[_index] != v.getXYZ() || _verts->_normals[_index] != v.getNormal());};
 
 	// Input and Output
 	friend std::ostream&	operator<<(std::ostream& , const vertex& );
@@ -159,135 +151,49 @@ public:
 //	friend istream&
 //	operator>>(istream& is, vertex& vi);
 
-	// NOTE: a better solution would be to return a reference
-	const float* getArrayVerts() const {
-		_v[0]=_myVertex.x;
-		_v[1]=_myVertex.y;
-		_v[2]=_myVertex.z;
-		return _v;}
-
-	const float* getArrayVertNorms() const {
-		_vn[0]=_vertexNormal.x;
-		_vn[1]=_vertexNormal.y;
-		_vn[2]=_vertexNormal.z;
-		return _vn;}
-
-	// a vertex neighbor is connected by an edge
-	void addVertNeighbor(int v)
-	{
-		_vertNeighbors.insert(v);
-	}
-
-	// remove a vertex which is no longer connected by an edge
-	unsigned removeVertNeighbor(int v) {return _vertNeighbors.erase(v);}
+	const float* getArrayVerts() const {return &_verts->_positions[_index].x;}
+	const float* getArrayVertNorms() const {return &_verts->_normals[_index].x;}
 
-	// a triangle neighbor is a triangle which uses this vertex
-	void addTriNeighbor(int t)
-	{
-		_triNeighbors.insert(t);
-	}
+	Vec3& getXYZ() {return _verts->_positions[_index];};
+	const Vec3& getXYZ() const {return _verts->_positions[_index];};
 
-	// remove triangle if it no longer uses this vertex
-	unsigned  removeTriNeighbor(int t) {return _triNeighbors.erase(t);}
-
-	Vec3& getXYZ() {return _myVertex;};
-	const Vec3& getXYZ() const {return _myVertex;};
+	const Vec3& getNormal() const {return _verts->_normals[_index];};
 
 	// if a vertex is removed, we set a flag
-	bool isActive() const {return _bActive;};
-	void setActive(bool b) {_bActive = b;};
-
-	const set<int>& getVertNeighbors() const {return _vertNeighbors;}
-	set<int>& getVertNeighbors() {return _vertNeighbors;}
-	const set<int>& getTriNeighbors() const {return _triNeighbors;}
-	set<int>& getTriNeighbors() {return _triNeighbors;}
-
-	bool hasVertNeighbor(int v) const {return (_vertNeighbors.find(v) != _vertNeighbors.end());}
-	bool hasTriNeighbor(int t) const {return (_triNeighbors.find(t) != _triNeighbors.end());}
+	bool isActive() const {return 0 != _verts->_active[_index];};
+	void setActive(bool b) {_verts->_active[_index] = b;};
 
 	// edge remove costs are used in mesh simplification
-	double edgeRemoveCost() {return _cost;};
-	void setEdgeRemoveCost(double f) {_cost = f;};
+	double edgeRemoveCost() {return _verts->_costs[_index];};
+	void setEdgeRemoveCost(double f) {_verts->_costs[_index] = f;};
 
-	int minCostEdgeVert() const {return _minCostNeighbor;};
-	void setMinCostEdgeVert(int i) {_minCostNeighbor = i;}
+	int minCostEdgeVert() const {return _verts->_minCostNeighbors[_index];};
+	void setMinCostEdgeVert(int i) {_verts->_minCostNeighbors[_index] = i;}
 
-	double getCost() const {return _cost;}
+	double getCost() const {return _verts->_costs[_index];}
 
 	// operator< & operator> are used to order vertices by edge removal costs
-	bool operator<(const vertex& v) const {return (_cost < v._cost);}
-	bool operator>(const vertex& v) const {return (_cost > v._cost);}
+	bool operator<(const vertex& v) const {return (getCost() < v.getCost());}
+	bool operator>(const vertex& v) const {return (getCost() > v.getCost());}
 
 	int getIndex() const {return _index;}
-	void setIndex(int i) {_index = i;}
 
 	// Used for Garland & Heckbert's quadric edge collapse cost (used for mesh simplifications/progressive meshes)
-	void calcQuadric(Mesh& m, bool bUseTriArea); // calculate the 4x4 Quadric matrix
-
-	void getQuadric(double Qret[4][4]) 
-	{
-		for (int i = 0; i < 4; ++i) {
-			for (int j = 0; j < 4; ++j) {
-				Qret[i][j] = _Q[i][j];
-			}
-		}
-	}
-
-	void setQuadric(double Qnew[4][4]) 
-	{
-		for (int i = 0; i < 4; ++i) {
-			for (int j = 0; j < 4; ++j) {
-				 _Q[i][j] = Qnew[i][j];
-			}
-		}
-	}
+	void calcQuadric(Mesh& m, const float* triAreas); // calculate the Quadric (triAreas is NULL if not weighting by area)
 
+	Quadric& getQuadric() {return _verts->_quadrics[_index];}
+	const Quadric& getQuadric() const {return _verts->_quadrics[_index];}
 
-	bool isBorder(Mesh& m); // is this vertex on the border 
-							// (i.e. is there an edge which uses this vertex which 
-							// is only used for one triangle?)
 
 	// Used for Gouraud shading
-	void setVertNomal(const Vec3& vn) {_vertexNormal = vn;};
-
-	double getQuadricSummedTriArea() {return _QTriArea;};
-	void setQuadricSummedTriArea(double newArea) {_QTriArea = newArea;};
+	void setVertNomal(const Vec3& vn) {_verts->_normals[_index] = vn;};
 
-	// Is the current vertex on an edge?  If so, get edge information.
-	// This is used to put constraints on the border so that the mesh
-	// edges aren't "eaten away" by the mesh simplification.
-	void getAllBorderEdges(set<border> &borderSet, Mesh& m);
+	double getQuadricSummedTriArea() {return _verts->_quadricTriAreas[_index];};
+	void setQuadricSummedTriArea(double newArea) {_verts->_quadricTriAreas[_index] = newArea;};
 
 private:
-	Vec3 _myVertex; // X, Y, Z position of this vertex
-	Vec3 _vertexNormal; // vertex normal, used for Gouraud shading
-
-	set<int> _vertNeighbors; // connected to this vertex via an edge
-	set<int> _triNeighbors; // triangles of which this vertex is a part
-
-	bool _bActive; // false if vertex has been removed
-
-	double _cost; // cost of removing this vertex from Progressive Mesh
-	int _minCostNeighbor; // index of vertex at other end of the min. cost edge
-
-	int _index;
-
-	mutable float _v[3];
-	mutable float _vn[3];
-
-	double _Q[4][4]; // Used for Quadric error cost.
-
-	double _QTriArea; // summed area of triangles used to computer quadrics
-
-	// Used for Garland & Heckbert's quadric edge collapse cost (used for mesh simplifications/progressive meshes)
-	void initQuadric()
-	{
-		for (int i = 0; i < 4; ++i) {
-			for (int j = 0; j < 4; ++j) {
-				_Q[i][j] = -1;
-			}
-		}
-	}
+	VertexArrays* _verts; // arrays which hold the vertex data
+	int _index; // index of this vertex in the arrays
 };
 
-#endif // #ifndef __vertex_h
\ No newline at end of file
+#endif // #ifndef __vertex_h
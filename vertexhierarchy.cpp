@@ -0,0 +1,218 @@
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <math.h>
+#include <algorithm>
+#include "mesh.h"
+#include "vertexhierarchy.h"
+
+static float pointDistance(const Vec3& a, const Vec3& b)
+{
+	const Vec3 d = a - b;
+	return (float) sqrt(d.dot(d));
+}
+
+// The planes of the frustum are the rows of projection * modelview,
+// added to or subtracted from the 4th row (Gribb & Hartmann).  They're
+// normalized, so the planes give distances.  The camera is at the origin
+// of eye space, so it's at -R^T t in the mesh's coordinates.
+void ViewParams::setFromMatrices(const float modelview[16], const float projection[16],
+								 int viewportHeight, float maxError)
+{
+	float m[16];
+	int i, j;
+	for (i = 0; i < 4; ++i)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			m[4 * j + i] = projection[i] * modelview[4 * j] + projection[4 + i] * modelview[4 * j + 1] +
+						   projection[8 + i] * modelview[4 * j + 2] + projection[12 + i] * modelview[4 * j + 3];
+		}
+	}
+
+	for (i = 0; i < 6; ++i)
+	{
+		const int row = i / 2;
+		const float sign = (i % 2) ? -1.0f : 1.0f;
+		float* p = _planes[i];
+		for (j = 0; j < 4; ++j)
+		{
+			p[j] = m[4 * j + 3] + sign * m[4 * j + row];
+		}
+		const float len = (float) sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+		if (len > 0)
+		{
+			for (j = 0; j < 4; ++j) p[j] /= len;
+		}
+	}
+
+	const float* t = modelview + 12;
+	_eye.x = -(modelview[0] * t[0] + modelview[1] * t[1] + modelview[2] * t[2]);
+	_eye.y = -(modelview[4] * t[0] + modelview[5] * t[1] + modelview[6] * t[2]);
+	_eye.z = -(modelview[8] * t[0] + modelview[9] * t[1] + modelview[10] * t[2]);
+
+	// projection[5] is cot(fov / 2) for a perspective projection
+	_pixelsPerUnit = projection[5] * viewportHeight / 2;
+	_maxError = maxError;
+}
+
+void VertexHierarchy::clear()
+{
+	_dependencies = CSRAdjacency();
+	_dependents = CSRAdjacency();
+	_merges = CSRAdjacency();
+	_removedBy.clear();
+	_centers.clear();
+	_radii.clear();
+	_errors.clear();
+}
+
+// Replay the edge collapses on a copy of the triangles' vertices & the
+// vertex positions, & note which earlier collapse last changed each
+// triangle & each vertex.  The dependencies are gathered as pairs, &
+// then sorted into rows.
+void VertexHierarchy::build(const CollapseHistory& history, const Mesh& mesh)
+{
+	const int nCollapses = history.size();
+	const int nVerts = mesh.getNumVerts();
+	const int nTris = mesh.getNumTriangles();
+	int i, n;
+
+	vector<int> pairs; // (vertex, collapse), then (dependency, collapse)
+	pairs.reserve(2 * (size_t) nCollapses);
+	_removedBy.assign(nVerts, -1);
+	for (n = 0; n < nCollapses; ++n)
+	{
+		_removedBy[history[n]._vfrom] = n;
+		pairs.push_back(history[n]._vto);
+		pairs.push_back(n);
+	}
+	_merges.buildFromPairs(pairs.empty() ? 0 : &pairs[0], nCollapses, nVerts);
+	pairs.clear();
+
+	vector<int> triVerts(3 * (size_t) nTris);
+	for (i = 0; i < nTris; ++i)
+	{
+		for (int k = 0; k < 3; ++k) triVerts[3 * i + k] = mesh.getTri(i).getVertIndex(k);
+	}
+	const Vec3* origPositions = mesh.getVertexArrays().getPositions();
+	vector<Vec3> positions(origPositions, origPositions + nVerts);
+	vector<float> moved(nVerts, 0); // farthest any vertex merged into each one has moved
+
+	vector<int> lastTriChange(nTris, -1);
+	vector<int> lastVertChange(nVerts, -1);
+
+	_centers.resize(nCollapses);
+	_radii.resize(nCollapses);
+	_errors.resize(nCollapses);
+
+	for (n = 0; n < nCollapses; ++n)
+	{
+		const CollapseRecord& ec = history[n];
+		const Vec3 center = history.movesToVert(n) ? history.position(n) : positions[ec._vto];
+
+		// Both vertices end up at the center
+		const float fromDist = pointDistance(positions[ec._vfrom], center);
+		const float toDist = pointDistance(positions[ec._vto], center);
+		float radius = max(fromDist, toDist);
+		const float error = max(moved[ec._vfrom] + fromDist, moved[ec._vto] + toDist);
+
+		const int verts[2] = {ec._vfrom, ec._vto};
+		for (i = 0; i < 2; ++i)
+		{
+			if (lastVertChange[verts[i]] >= 0)
+			{
+				pairs.push_back(lastVertChange[verts[i]]);
+				pairs.push_back(n);
+			}
+		}
+		lastVertChange[ec._vto] = n;
+
+		const AdjacencyRow rows[3] = {history.trisRemoved(n), history.trisAffected(n), history.trisMoved(n)};
+		for (i = 0; i < 3; ++i)
+		{
+			for (const int* tripos = rows[i].begin(); tripos != rows[i].end(); ++tripos)
+			{
+				const int t = *tripos;
+				if (lastTriChange[t] >= 0)
+				{
+					pairs.push_back(lastTriChange[t]);
+					pairs.push_back(n);
+				}
+				lastTriChange[t] = n;
+
+				for (int k = 0; k < 3; ++k)
+				{
+					const int u = triVerts[3 * t + k];
+					radius = max(radius, pointDistance(positions[u], center));
+					if (_removedBy[u] > n)
+					{
+						pairs.push_back(n);
+						pairs.push_back(_removedBy[u]);
+					}
+				}
+			}
+		}
+
+		// Same as triangle::changeVertex()
+		const AdjacencyRow trisAffected = history.trisAffected(n);
+		for (const int* tripos = trisAffected.begin(); tripos != trisAffected.end(); ++tripos)
+		{
+			int* v = &triVerts[3 * *tripos];
+			if (v[0] == ec._vfrom) v[0] = ec._vto;
+			else if (v[1] == ec._vfrom) v[1] = ec._vto;
+			else if (v[2] == ec._vfrom) v[2] = ec._vto;
+		}
+		positions[ec._vto] = center;
+		moved[ec._vto] = error;
+
+		_centers[n] = center;
+		_radii[n] = radius;
+		_errors[n] = error;
+	}
+
+	const int nPairs = (int) pairs.size() / 2;
+	_dependents.buildFromPairs(pairs.empty() ? 0 : &pairs[0], nPairs, nCollapses);
+	for (i = 0; i < nPairs; ++i)
+	{
+		swap(pairs[2 * i], pairs[2 * i + 1]);
+	}
+	_dependencies.buildFromPairs(pairs.empty() ? 0 : &pairs[0], nPairs, nCollapses);
+}
+
+// The error is largest on the screen at the point of the bounding
+// sphere nearest the camera.  If the camera is inside it, any error
+// may be too much.
+bool VertexHierarchy::needsDetail(int n, const ViewParams& view) const
+{
+	const Vec3& c = _centers[n];
+	const float r = _radii[n];
+
+	// No detail is needed outside the view frustum
+	for (int i = 0; i < 6; ++i)
+	{
+		const float* p = view._planes[i];
+		if (p[0] * c.x + p[1] * c.y + p[2] * c.z + p[3] < -r) return false;
+	}
+
+	const float dist = pointDistance(view._eye, c) - r;
+	if (dist <= 0) return true;
+	return _errors[n] * view._pixelsPerUnit > view._maxError * dist;
+}
+
+size_t VertexHierarchy::bytesUsed() const
+{
+	const CSRAdjacency* adj[3] = {&_dependencies, &_dependents, &_merges};
+	size_t nBytes = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		nBytes += (adj[i]->getNumRows() + 1 + adj[i]->getNumEntries()) * sizeof(int);
+	}
+	return nBytes + _removedBy.size() * sizeof(int) +
+		   _centers.size() * sizeof(Vec3) +
+		   _radii.size() * sizeof(float) +
+		   _errors.size() * sizeof(float);
+}
@@ -0,0 +1,97 @@
+#ifndef __vertexhierarchy_h
+#define __vertexhierarchy_h
+
+#if defined (_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#pragma warning(disable:4710) // function not inlined
+#pragma warning(disable:4702) // unreachable code
+#pragma warning(disable:4514) // unreferenced inline function has been removed
+#endif
+
+#include <vector>
+#include "vec3.h"
+#include "adjacency.h"
+#include "collapsehistory.h"
+
+using namespace std;
+
+class Mesh;
+
+// The view used for view-dependent refinement (see
+// PMesh::refineForView).  The mesh needs more detail where an edge
+// collapse would move its vertices by more than _maxError pixels on the
+// screen, & none outside the view frustum.
+struct ViewParams
+{
+	Vec3 _eye; // position of the camera, in the mesh's coordinates
+	float _planes[6][4]; // view frustum:  p is inside if a*x + b*y + c*z + d >= 0 for each plane (a, b, c, d)
+	float _pixelsPerUnit; // # of pixels a length of 1 covers, facing the camera at a distance of 1
+	float _maxError; // most a vertex can be off on the screen, in pixels
+
+	// Get the view from OpenGL's modelview & projection matrices
+	// (column-major, as returned by glGetFloatv()), for a viewport
+	// viewportHeight pixels high.  The modelview matrix can't scale.
+	void setFromMatrices(const float modelview[16], const float projection[16],
+						 int viewportHeight, float maxError);
+};
+
+// The vertex hierarchy of a list of edge collapses, for view-dependent
+// refinement.  Each edge collapse merges its "from vertex" into its "to
+// vertex", so the collapses make a forest, w/ the vertices which are
+// never collapsed at the roots.  Any set of collapses can be done, as
+// long as each one's dependencies have been done first:
+//
+// - the collapse before it which changed each of its triangles, so the
+//   triangles have the vertices they had when it was built
+// - the collapse before it which merged a vertex into its "from vertex"
+//   or "to vertex", so the vertex is where it was when it was built
+// - any collapse after it which removes a vertex of its triangles has it
+//   as a dependency, so a visible triangle never uses a collapsed vertex
+//
+// The dependencies always come earlier in the list, so doing the
+// collapses in order (or undoing them in reverse) always works.  (Hoppe's
+// selective refinement uses the same kind of dependencies.)
+class VertexHierarchy
+{
+public:
+	VertexHierarchy() {};
+
+	void clear();
+	bool empty() const {return _centers.empty();}
+
+	// Build it from the list of edge collapses, & the mesh before any of
+	// them have been done
+	void build(const CollapseHistory& history, const Mesh& mesh);
+
+	// The collapses which have to be done before edge collapse n, & the
+	// ones which have to be undone before it's undone
+	AdjacencyRow dependencies(int n) const {return _dependencies.row(n);}
+	AdjacencyRow dependents(int n) const {return _dependents.row(n);}
+
+	// The edge collapse which removes vertex v (as the "from vertex"),
+	// or -1 if it's never removed, & the collapses which merge other
+	// vertices into it, in order.  The merges are a chain of
+	// dependencies, so the ones which are done are always the first few.
+	int removedBy(int v) const {return _removedBy[v];}
+	AdjacencyRow merges(int v) const {return _merges.row(v);}
+
+	// Does edge collapse n need to be undone, to show the mesh w/ as much
+	// detail as the view needs?
+	bool needsDetail(int n, const ViewParams& view) const;
+
+	// Bytes used by the hierarchy (not counting spare capacity)
+	size_t bytesUsed() const;
+
+private:
+	CSRAdjacency _dependencies;
+	CSRAdjacency _dependents;
+	CSRAdjacency _merges;
+	vector<int> _removedBy;
+
+	// The part of the mesh each edge collapse changes, for the view tests
+	vector<Vec3> _centers; // where the "to vertex" is after the collapse
+	vector<float> _radii; // bounds the vertices of the triangles it changes
+	vector<float> _errors; // farthest any vertex merged into the "to vertex" has moved
+};
+
+#endif // __vertexhierarchy_h